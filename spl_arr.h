@@ -0,0 +1,505 @@
+/*
+ ===============================================================================
+ |                                  spl_arr.h                                  |
+ |                     https://github.com/mrsafalpiya/spl                      |
+ |                                                                             |
+ |               Type-generic dynamic arrays (stretchy buffers)                |
+ |                                                                             |
+ |                  No warranty implied; Use at your own risk                  |
+ |                  See end of file for license information.                   |
+ ===============================================================================
+ */
+
+/*
+ ===============================================================================
+ |                               Version History                               |
+ ===============================================================================
+ *
+ - v0.1 (Current)
+ */
+
+/*
+ ===============================================================================
+ |                                    Usage                                    |
+ ===============================================================================
+ *
+ * Do this:
+ *
+ *         #define SPL_ARR_IMPL
+ *
+ * before you include this file in *one* C or C++ file to create the
+ * implementation.
+ *
+ * An array is a plain pointer to its elements, initialized to NULL, with its
+ * length and capacity stored right before the first element:
+ *
+ *         int *a = NULL;
+ *
+ *         spl_arr_push(a, 1);
+ *         spl_arr_push(a, 2);
+ *         for (size_t i = 0; i < spl_arr_len(a); i++)
+ *                 printf("%d\n", a[i]);
+ *         spl_arr_free(a);
+ *
+ * As the macros may move the array, they take the variable holding it and
+ * assign it; other pointers into the array are invalidated by any growth.
+ * Arguments other than the array may be evaluated more than once.
+ */
+
+/*
+ ===============================================================================
+ |                              HEADER-FILE MODE                               |
+ ===============================================================================
+ */
+
+#ifndef SPL_ARR_H
+#define SPL_ARR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+#include <new>
+#include <type_traits>
+#include <utility>
+#endif
+
+/*
+ ===============================================================================
+ |                                   Options                                   |
+ ===============================================================================
+ */
+
+/* = SPL_ARR = */
+#ifndef SPL_ARR_DEF
+#define SPL_ARR_DEF /* You may want `static` or `static inline` here */
+#endif
+
+/* = SPL_ARR_REALLOC = */
+/* The allocator, defaulting to 'realloc()' and 'free()'. Define both to use
+ * another one, e.g. an arena shared with the rest of the program. Given the
+ * current size of a block, an allocator unable to grow in place can allocate
+ * and copy. `ptr` is NULL with `old_size` 0 for a new block. */
+#ifndef SPL_ARR_REALLOC
+#define SPL_ARR_REALLOC(ptr, old_size, new_size) \
+	((void)(old_size), realloc((ptr), (new_size)))
+#define SPL_ARR_FREE(ptr, size) ((void)(size), free(ptr))
+#endif
+
+/* = SPL_ARR_OUT_OF_MEMORY = */
+/* Called when an allocation fails, as the macros have no way to report it.
+ * Must not return. */
+#ifndef SPL_ARR_OUT_OF_MEMORY
+#define SPL_ARR_OUT_OF_MEMORY() abort()
+#endif
+
+/*
+ ===============================================================================
+ |                                    Data                                     |
+ ===============================================================================
+ */
+
+/* Stored right before the first element of an array */
+typedef struct {
+	size_t len;
+	size_t cap;
+} spl_arr_header;
+
+/*
+ ===============================================================================
+ |                                   Macros                                    |
+ ===============================================================================
+ */
+
+/* Returns the header of the non-NULL array `a`. */
+#define spl_arr_header_of(a) ((spl_arr_header *)(void *)(a) - 1)
+
+/* Returns the number of elements in `a`, 0 if NULL. */
+#define spl_arr_len(a) ((a) ? spl_arr_header_of(a)->len : 0)
+
+/* Returns the number of elements `a` can hold without growing, 0 if NULL. */
+#define spl_arr_cap(a) ((a) ? spl_arr_header_of(a)->cap : 0)
+
+/* Returns the last element of the non-empty `a`. */
+#define spl_arr_last(a) ((a)[spl_arr_header_of(a)->len - 1])
+
+/*
+ * The macros below are implemented for C with 'memmove()' and plain
+ * assignment, and for C++ by the templates of the "C++ Mode" section which
+ * move-construct, move-assign and destroy the elements instead, so that any
+ * type may be stored.
+ */
+
+#ifndef __cplusplus
+
+/* Appends `v` to `a`, growing it geometrically: amortized O(1). */
+#define spl_arr_push(a, v) \
+	(spl_arr__fit((a), 1), (a)[spl_arr_header_of(a)->len++] = (v))
+
+/* Appends `n` uninitialized elements to `a` and returns a pointer to the first
+ * of them (value-initialized in C++). */
+#define spl_arr_addn(a, n)                         \
+	(spl_arr__fit((a), (n)),                   \
+	 spl_arr_header_of(a)->len += (n),         \
+	 &(a)[spl_arr_header_of(a)->len - (n)])
+
+/* Removes and returns the last element of the non-empty `a`. */
+#define spl_arr_pop(a) ((a)[--spl_arr_header_of(a)->len])
+
+/* Inserts `v` at index `i` of `a`, moving the following elements up. `v` is
+ * stored in the spare slot past the new end before the move, so it may be an
+ * element of `a`. */
+#define spl_arr_insert(a, i, v)                                          \
+	(spl_arr__fit((a), 2),                                           \
+	 (a)[spl_arr_header_of(a)->len + 1] = (v),                       \
+	 memmove(&(a)[(i) + 1], &(a)[i],                                 \
+	         (spl_arr_header_of(a)->len++ - (i)) * sizeof(*(a))),    \
+	 memcpy(&(a)[i], &(a)[spl_arr_header_of(a)->len], sizeof(*(a))))
+
+/* Removes the element at index `i` of `a`, moving the following elements
+ * down. */
+#define spl_arr_del(a, i)                                               \
+	memmove(&(a)[i], &(a)[(i) + 1],                                 \
+	        (--spl_arr_header_of(a)->len - (i)) * sizeof(*(a)))
+
+/* Removes the element at index `i` of `a` by moving the last one in its place:
+ * O(1) but doesn't keep the order. */
+#define spl_arr_del_swap(a, i) ((a)[i] = (a)[--spl_arr_header_of(a)->len])
+
+/* Makes `a` able to hold `n` elements without growing. Always allocates a NULL
+ * `a`. */
+#define spl_arr_reserve(a, n)                                          \
+	((!(a) || (n) > spl_arr_header_of(a)->cap) ?                   \
+	         ((a) = spl_arr__set_cap((a), sizeof(*(a)), (n)), 0) : \
+	         0)
+
+/* Sets the length of `a` to `n`, the new elements being uninitialized
+ * (value-initialized in C++). */
+#define spl_arr_setlen(a, n) \
+	(spl_arr_reserve((a), (n)), spl_arr_header_of(a)->len = (n))
+
+/* Reduces the capacity of `a` to its length. */
+#define spl_arr_shrink(a)                                                     \
+	((a) ? ((a) = spl_arr__set_cap((a), sizeof(*(a)),                     \
+	                               spl_arr_header_of(a)->len),            \
+	        0) :                                                          \
+	       0)
+
+/* Removes every element of `a`, keeping its capacity. */
+#define spl_arr_clear(a) ((a) ? (spl_arr_header_of(a)->len = 0) : 0)
+
+/* Frees `a` and sets it to NULL. */
+#define spl_arr_free(a) \
+	((a) ? (spl_arr__free((a), sizeof(*(a))), (a) = NULL, 0) : 0)
+
+/* Grows `a` if it can't take `n` more elements. */
+#define spl_arr__fit(a, n)                                                  \
+	((!(a) || spl_arr_header_of(a)->len + (n) >                         \
+	                  spl_arr_header_of(a)->cap) ?                      \
+	         ((a) = spl_arr__set_cap(                                   \
+	                  (a), sizeof(*(a)),                                \
+	                  spl_arr__grown_cap((a) ? spl_arr_header_of(a)->cap \
+	                                         : 0,                       \
+	                                     spl_arr_len(a) + (n))),        \
+	          0) :                                                      \
+	         0)
+
+#else /* __cplusplus */
+
+#define spl_arr_push(a, v)      spl_arr__push((a), (v))
+#define spl_arr_addn(a, n)      spl_arr__addn((a), (n))
+#define spl_arr_pop(a)          spl_arr__pop(a)
+#define spl_arr_insert(a, i, v) spl_arr__insert((a), (i), (v))
+#define spl_arr_del(a, i)       spl_arr__del((a), (i))
+#define spl_arr_del_swap(a, i)  spl_arr__del_swap((a), (i))
+#define spl_arr_reserve(a, n)   spl_arr__reserve((a), (n))
+#define spl_arr_setlen(a, n)    spl_arr__setlen((a), (n))
+#define spl_arr_shrink(a)       spl_arr__shrink(a)
+#define spl_arr_clear(a)        spl_arr__clear(a)
+#define spl_arr_free(a)         spl_arr__free_all(a)
+
+#endif /* __cplusplus */
+
+/*
+ ===============================================================================
+ |                            Function Declarations                            |
+ ===============================================================================
+ */
+
+/* Used by the macros: returns `a` (possibly moved) with room for exactly `cap`
+ * elements of `elem_size` bytes, but never less than its length. `a` may be
+ * NULL. */
+SPL_ARR_DEF void *
+spl_arr__set_cap(void *a, size_t elem_size, size_t cap);
+
+/* Used by the macros: frees the non-NULL `a`. */
+SPL_ARR_DEF void
+spl_arr__free(void *a, size_t elem_size);
+
+/* Used by the macros: returns the capacity to grow `cap` to for `min_cap`
+ * elements. Doubling keeps pushes amortized O(1). */
+static inline size_t
+spl_arr__grown_cap(size_t cap, size_t min_cap)
+{
+	cap = cap < 4 ? 8 : cap * 2;
+	return cap < min_cap ? min_cap : cap;
+}
+
+#ifdef __cplusplus
+
+/*
+ ===============================================================================
+ |                                  C++ Mode                                   |
+ ===============================================================================
+ */
+
+/* Elements get moved one by one rather than reallocated in place, unless they
+ * are trivially copyable. */
+
+template <typename T>
+static inline void
+spl_arr__relocate(T *&a, size_t cap)
+{
+	size_t len = spl_arr_len(a);
+	T     *b;
+
+	if (std::is_trivially_copyable<T>::value) {
+		a = (T *)spl_arr__set_cap(a, sizeof(T), cap);
+		return;
+	}
+
+	b = (T *)spl_arr__set_cap(NULL, sizeof(T), cap < len ? len : cap);
+	for (size_t i = 0; i < len; i++) {
+		new (&b[i]) T(std::move(a[i]));
+		a[i].~T();
+	}
+	spl_arr_header_of(b)->len = len;
+	if (a)
+		spl_arr__free(a, sizeof(T));
+	a = b;
+}
+
+template <typename T>
+static inline void
+spl_arr__fit(T *&a, size_t n)
+{
+	if (!a || spl_arr_header_of(a)->len + n > spl_arr_header_of(a)->cap)
+		spl_arr__relocate(a, spl_arr__grown_cap(spl_arr_cap(a),
+		                                        spl_arr_len(a) + n));
+}
+
+template <typename T, typename U>
+static inline T &
+spl_arr__push(T *&a, U &&v)
+{
+	if (!a || spl_arr_header_of(a)->len == spl_arr_header_of(a)->cap) {
+		/* `v` may be an element of `a` */
+		T tmp(std::forward<U>(v));
+		spl_arr__fit(a, 1);
+		new (&a[spl_arr_header_of(a)->len]) T(std::move(tmp));
+	} else {
+		new (&a[spl_arr_header_of(a)->len]) T(std::forward<U>(v));
+	}
+	return a[spl_arr_header_of(a)->len++];
+}
+
+template <typename T>
+static inline T *
+spl_arr__addn(T *&a, size_t n)
+{
+	size_t len;
+
+	spl_arr__fit(a, n);
+	len = spl_arr_header_of(a)->len;
+	for (size_t i = len; i < len + n; i++)
+		new (&a[i]) T();
+	spl_arr_header_of(a)->len += n;
+	return &a[len];
+}
+
+template <typename T>
+static inline T
+spl_arr__pop(T *a)
+{
+	T v(std::move(a[--spl_arr_header_of(a)->len]));
+
+	a[spl_arr_header_of(a)->len].~T();
+	return v;
+}
+
+template <typename T, typename U>
+static inline T &
+spl_arr__insert(T *&a, size_t i, U &&v)
+{
+	T      tmp(std::forward<U>(v));
+	size_t len;
+
+	spl_arr__fit(a, 1);
+	len = spl_arr_header_of(a)->len;
+	if (i == len) {
+		new (&a[len]) T(std::move(tmp));
+	} else {
+		new (&a[len]) T(std::move(a[len - 1]));
+		for (size_t j = len - 1; j > i; j--)
+			a[j] = std::move(a[j - 1]);
+		a[i] = std::move(tmp);
+	}
+	spl_arr_header_of(a)->len++;
+	return a[i];
+}
+
+template <typename T>
+static inline void
+spl_arr__del(T *a, size_t i)
+{
+	size_t len = --spl_arr_header_of(a)->len;
+
+	for (; i < len; i++)
+		a[i] = std::move(a[i + 1]);
+	a[len].~T();
+}
+
+template <typename T>
+static inline void
+spl_arr__del_swap(T *a, size_t i)
+{
+	size_t len = --spl_arr_header_of(a)->len;
+
+	if (i != len)
+		a[i] = std::move(a[len]);
+	a[len].~T();
+}
+
+template <typename T>
+static inline void
+spl_arr__reserve(T *&a, size_t n)
+{
+	if (!a || n > spl_arr_header_of(a)->cap)
+		spl_arr__relocate(a, n);
+}
+
+template <typename T>
+static inline void
+spl_arr__setlen(T *&a, size_t n)
+{
+	size_t len;
+
+	spl_arr__reserve(a, n);
+	for (len = spl_arr_header_of(a)->len; len < n; len++)
+		new (&a[len]) T();
+	for (; len > n; len--)
+		a[len - 1].~T();
+	spl_arr_header_of(a)->len = n;
+}
+
+template <typename T>
+static inline void
+spl_arr__shrink(T *&a)
+{
+	if (a)
+		spl_arr__relocate(a, spl_arr_header_of(a)->len);
+}
+
+template <typename T>
+static inline void
+spl_arr__clear(T *a)
+{
+	if (!a)
+		return;
+	for (size_t i = 0; i < spl_arr_header_of(a)->len; i++)
+		a[i].~T();
+	spl_arr_header_of(a)->len = 0;
+}
+
+template <typename T>
+static inline void
+spl_arr__free_all(T *&a)
+{
+	if (!a)
+		return;
+	spl_arr__clear(a);
+	spl_arr__free(a, sizeof(T));
+	a = NULL;
+}
+
+#endif /* __cplusplus */
+
+#endif /* SPL_ARR_H */
+
+/*
+ ===============================================================================
+ |                             IMPLEMENTATION MODE                             |
+ ===============================================================================
+ */
+
+#ifdef SPL_ARR_IMPL
+
+/*
+ ===============================================================================
+ |                          Function Implementations                           |
+ ===============================================================================
+ */
+
+SPL_ARR_DEF void *
+spl_arr__set_cap(void *a, size_t elem_size, size_t cap)
+{
+	spl_arr_header *h        = a ? spl_arr_header_of(a) : NULL;
+	size_t          len      = h ? h->len : 0;
+	size_t          old_size = h ? sizeof(*h) + h->cap * elem_size : 0;
+
+	if (cap < len)
+		cap = len;
+	if (cap > (SIZE_MAX - sizeof(*h)) / elem_size)
+		SPL_ARR_OUT_OF_MEMORY();
+
+	h = (spl_arr_header *)SPL_ARR_REALLOC(h, old_size,
+	                                      sizeof(*h) + cap * elem_size);
+	if (!h)
+		SPL_ARR_OUT_OF_MEMORY();
+	h->len = len;
+	h->cap = cap;
+	return h + 1;
+}
+
+SPL_ARR_DEF void
+spl_arr__free(void *a, size_t elem_size)
+{
+	spl_arr_header *h = spl_arr_header_of(a);
+
+	SPL_ARR_FREE(h, sizeof(*h) + h->cap * elem_size);
+}
+
+#endif /* SPL_ARR_IMPL */
+
+/*
+ ===============================================================================
+ |                 License - Public Domain (www.unlicense.org)                 |
+ ===============================================================================
+ *
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
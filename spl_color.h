@@ -15,7 +15,36 @@
  |                               Version History                               |
  ===============================================================================
  *
- - v0.1 (Current)
+ - v0.2 (Current)
+     - Added bulk pixel format conversions: 'splcol_swap_rb()',
+       'splcol_rgba_to_rgb565()', 'splcol_rgb565_to_rgba()',
+       'splcol_rgba_to_float()' and 'splcol_float_to_rgba()'.
+     - Added sRGB transfer functions: 'splcol_srgb_to_linear()',
+       'splcol_linear_to_srgb()', 'splcol_srgb_to_linear_float()' and
+       'splcol_linear_float_to_srgb()'.
+     - Added compositing of premultiplied and straight alpha scanlines:
+       'splcol_blend()', 'splcol_blend_straight()', 'splcol_premultiply()' and
+       'splcol_unpremultiply()'.
+     - Added HSV, HSL and OKLab conversions with structure of arrays batch
+       versions: 'splcol_rgb_to_hsv()', 'splcol_hsv_to_rgb()',
+       'splcol_rgb_to_hsl()', 'splcol_hsl_to_rgb()', 'splcol_rgb_to_oklab()',
+       'splcol_oklab_to_rgb()' and their '_soa()' variants.
+     - Added palettes with a nearest color lookup table and median cut plus
+       k-means quantization: 'splcol_palette_init()',
+       'splcol_palette_quantize()', 'splcol_palette_free()',
+       'splcol_palette_lookup()', 'splcol_palette_nearest()' and
+       'splcol_palette_map()'.
+     - Added hex color string parsing and formatting: 'splcol_hex_parse()',
+       'splcol_hex_parse_n()', 'splcol_hex_format()' and
+       'splcol_hex_format_n()'.
+     - Added multi-stop gradients interpolated in sRGB, linear light or OKLab:
+       'splcol_gradient()'.
+     - Added a buffered terminal color writer with 16, 256 and truecolor modes:
+       'SPLCOL_TERM_DEFAULT', 'splcol_term_detect()', 'splcol_term_init()',
+       'splcol_term_free()', 'splcol_term_fg()', 'splcol_term_bg()',
+       'splcol_term_reset()', 'splcol_term_write()', 'splcol_term_printf()'
+       and 'splcol_term_flush()'.
+ - v0.1
  */
 
 /*
@@ -40,6 +69,10 @@
 #ifndef SPLCOL_H
 #define SPLCOL_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 /*
  ===============================================================================
  |                                   Options                                   |
@@ -51,6 +84,10 @@
 #define SPLCOL_DEF /* You may want `static` or `static inline` here */
 #endif
 
+/* The bulk functions use SSE2 and AVX2 when the compiler targets them (e.g.
+ * '-msse2', '-mavx2' or '-march=native'). Define 'SPLCOL_NO_SIMD' to always use
+ * the plain C versions. */
+
 /*
  ===============================================================================
  |                                   Macros                                    |
@@ -78,12 +115,395 @@
 		(float)(((hex) >> (1 * 8)) & 0xFF) / 255.0, \
 		(float)(((hex) >> (0 * 8)) & 0xFF) / 255.0
 
+/* = TERMINAL = */
+
+/* Color selecting the default foreground or background of the terminal. Any
+ * color with a 0 alpha does the same. */
+#define SPLCOL_TERM_DEFAULT 0x00000000
+
+/*
+ ===============================================================================
+ |                                    Data                                     |
+ ===============================================================================
+ */
+
+/* = COMPOSITING = */
+
+/* How 'splcol_blend()' combines a source pixel with the destination pixel it
+ * is drawn on */
+typedef enum {
+	SPLCOL_BLEND_OVER,     /* Porter-Duff source over destination */
+	SPLCOL_BLEND_ADD,      /* Porter-Duff plus, saturating at 255 */
+	SPLCOL_BLEND_MULTIPLY, /* Multiply blend composited over */
+} splcol_blend_mode;
+
+/* = PALETTE = */
+
+/* Up to 256 colors along with a lookup table mapping every color, reduced to 5
+ * bits per channel, to the index of its nearest palette color */
+typedef struct {
+	uint32_t colors[256];
+	int      colors_c;
+	uint8_t *lut;
+} splcol_palette;
+
+/* = GRADIENTS = */
+
+/* Color space 'splcol_gradient()' interpolates in */
+typedef enum {
+	SPLCOL_GRADIENT_SRGB,   /* Channels as they are, like CSS gradients */
+	SPLCOL_GRADIENT_LINEAR, /* Linear light, no dark band between hues */
+	SPLCOL_GRADIENT_OKLAB,  /* Perceptually even steps */
+} splcol_gradient_space;
+
+/* Color of a gradient at position `pos`, usually in [0, 1] */
+typedef struct {
+	float    pos;
+	uint32_t color;
+} splcol_gradient_stop;
+
+/* = TERMINAL = */
+
+/* Colors a 'splcol_term' can emit */
+typedef enum {
+	SPLCOL_TERM_NONE,      /* No escapes at all, e.g. not a terminal */
+	SPLCOL_TERM_16,        /* The 16 standard colors */
+	SPLCOL_TERM_256,       /* The xterm 256 colors */
+	SPLCOL_TERM_TRUECOLOR, /* 24-bit colors */
+} splcol_term_mode;
+
+/* Buffered writer of colored text */
+typedef struct {
+	FILE            *stream;
+	splcol_term_mode mode;
+	int              err; /* Whether a write to 'stream' failed */
+	char            *buf;
+	size_t           buf_len;
+	size_t           buf_cap;
+	uint32_t         fg, bg; /* Last emitted colors, not to repeat them */
+	splcol_palette   pal16;  /* Lookup table for 'SPLCOL_TERM_16' */
+} splcol_term;
+
 /*
  ===============================================================================
  |                            Function Declarations                            |
  ===============================================================================
  */
 
+/*
+ * = BULK CONVERSION =
+ *
+ * Pixels are packed the same way as the 'SPLCOL_HEXA()' input i.e. a uint32
+ * 0xRRGGBBAA. BGRA pixels are 0xBBGGRRAA and RGB565 pixels are a uint16 with 5
+ * bits of red, 6 of green and 5 of blue from the most significant bit. Float
+ * pixels are 4 consecutive normalized floats in red, green, blue, alpha order.
+ *
+ * `n` is the number of pixels. `dst` and `src` may be the same array for the
+ * conversions keeping the pixel size.
+ */
+
+/* Swaps the red and blue channels of every pixel, converting RGBA to BGRA and
+ * back. */
+SPLCOL_DEF void
+splcol_swap_rb(uint32_t *dst, const uint32_t *src, size_t n);
+
+/* Converts RGBA pixels to RGB565, dropping the alpha and the low bits of each
+ * channel. */
+SPLCOL_DEF void
+splcol_rgba_to_rgb565(uint16_t *dst, const uint32_t *src, size_t n);
+
+/* Converts RGB565 pixels to opaque RGBA pixels, replicating the high bits of
+ * each channel into the missing low bits so that 0x1F becomes 0xFF. */
+SPLCOL_DEF void
+splcol_rgb565_to_rgba(uint32_t *dst, const uint16_t *src, size_t n);
+
+/* Same as 'SPLCOL_HEXGL()' for every pixel: writes `4 * n` floats into `dst`.
+ * Channels are multiplied by the reciprocal of 255 instead of divided. */
+SPLCOL_DEF void
+splcol_rgba_to_float(float *dst, const uint32_t *src, size_t n);
+
+/* Inverse of 'splcol_rgba_to_float()': reads `4 * n` floats from `src`,
+ * clamping them to [0, 1] (NaN becomes 0) and rounding to the nearest uint8. */
+SPLCOL_DEF void
+splcol_float_to_rgba(uint32_t *dst, const float *src, size_t n);
+
+/*
+ * = SRGB =
+ *
+ * 8-bit channels, as stored in images and written in hex colors, are sRGB
+ * encoded: the normalized values from 'SPLCOL_HEXGL()' are not linear light and
+ * blending them directly gives too dark results. Decode to linear, blend and
+ * encode back.
+ *
+ * Decoding is a lookup in a 256-entry table. Encoding evaluates a linear
+ * segment picked by the exponent and top mantissa bits of the value from a
+ * 104-entry table. It is off by at most 0.56 of an 8-bit step from the exact
+ * curve and every 8-bit value survives a decode and encode round trip.
+ */
+
+/* Returns the linear light value of the sRGB encoded channel `c`. */
+SPLCOL_DEF float
+splcol_srgb_to_linear(uint8_t c);
+
+/* Returns the sRGB encoded channel for the linear light value `v` clamped to
+ * [0, 1] (NaN becomes 0). */
+SPLCOL_DEF uint8_t
+splcol_linear_to_srgb(float v);
+
+/* Same as 'splcol_rgba_to_float()' but the color channels are also decoded to
+ * linear light. Alpha is never sRGB encoded so it is only normalized. */
+SPLCOL_DEF void
+splcol_srgb_to_linear_float(float *dst, const uint32_t *src, size_t n);
+
+/* Inverse of 'splcol_srgb_to_linear_float()'. */
+SPLCOL_DEF void
+splcol_linear_float_to_srgb(uint32_t *dst, const float *src, size_t n);
+
+/*
+ * = COMPOSITING =
+ *
+ * Pixels are 0xRRGGBBAA like the bulk conversions. Premultiplied pixels have
+ * their color channels already multiplied by their alpha, so no channel may be
+ * greater than the alpha; results for pixels breaking this are clamped but
+ * otherwise meaningless.
+ *
+ * Every product is divided by 255 with exact rounding, so blending with an
+ * opaque or fully transparent pixel gives back the pixel unchanged.
+ */
+
+/* Blends `n` premultiplied `src` pixels onto the premultiplied `dst` pixels,
+ * storing the result in `dst`. An unknown `mode` leaves `dst` untouched. */
+SPLCOL_DEF void
+splcol_blend(uint32_t *dst, const uint32_t *src, size_t n,
+             splcol_blend_mode mode);
+
+/* Same as 'splcol_blend()' but for straight (not premultiplied) pixels. The
+ * pixels are premultiplied in small stack chunks, blended and divided back, so
+ * prefer keeping layers premultiplied when compositing many of them. */
+SPLCOL_DEF void
+splcol_blend_straight(uint32_t *dst, const uint32_t *src, size_t n,
+                      splcol_blend_mode mode);
+
+/* Multiplies the color channels of the straight `src` pixels by their alpha. */
+SPLCOL_DEF void
+splcol_premultiply(uint32_t *dst, const uint32_t *src, size_t n);
+
+/* Inverse of 'splcol_premultiply()'. Pixels with 0 alpha become 0. */
+SPLCOL_DEF void
+splcol_unpremultiply(uint32_t *dst, const uint32_t *src, size_t n);
+
+/*
+ * = COLOR SPACES =
+ *
+ * Channels are floats. RGB, saturation, value and lightness are in [0, 1] and
+ * hue is a fraction of a turn in [0, 1) instead of degrees; hues outside of it
+ * are wrapped. OKLab works on linear light RGB (see the SRGB section), giving
+ * L in [0, 1] and a, b roughly in [-0.4, 0.4].
+ *
+ * The '_soa' versions convert `n` pixels stored as one array per channel
+ * (structure of arrays), 4 at a time with SSE2. The output arrays may be the
+ * same as the input ones.
+ */
+
+SPLCOL_DEF void
+splcol_rgb_to_hsv(float r, float g, float b, float *h, float *s, float *v);
+
+SPLCOL_DEF void
+splcol_hsv_to_rgb(float h, float s, float v, float *r, float *g, float *b);
+
+SPLCOL_DEF void
+splcol_rgb_to_hsl(float r, float g, float b, float *h, float *s, float *l);
+
+SPLCOL_DEF void
+splcol_hsl_to_rgb(float h, float s, float l, float *r, float *g, float *b);
+
+SPLCOL_DEF void
+splcol_rgb_to_oklab(float r, float g, float b, float *l, float *a, float *bb);
+
+/* Results out of the RGB gamut are not clamped. */
+SPLCOL_DEF void
+splcol_oklab_to_rgb(float l, float a, float bb, float *r, float *g, float *b);
+
+SPLCOL_DEF void
+splcol_rgb_to_hsv_soa(float *h, float *s, float *v, const float *r,
+                      const float *g, const float *b, size_t n);
+
+SPLCOL_DEF void
+splcol_hsv_to_rgb_soa(float *r, float *g, float *b, const float *h,
+                      const float *s, const float *v, size_t n);
+
+SPLCOL_DEF void
+splcol_rgb_to_hsl_soa(float *h, float *s, float *l, const float *r,
+                      const float *g, const float *b, size_t n);
+
+SPLCOL_DEF void
+splcol_hsl_to_rgb_soa(float *r, float *g, float *b, const float *h,
+                      const float *s, const float *l, size_t n);
+
+SPLCOL_DEF void
+splcol_rgb_to_oklab_soa(float *l, float *a, float *bb, const float *r,
+                        const float *g, const float *b, size_t n);
+
+SPLCOL_DEF void
+splcol_oklab_to_rgb_soa(float *r, float *g, float *b, const float *l,
+                        const float *a, const float *bb, size_t n);
+
+/*
+ * = PALETTE =
+ *
+ * Palette colors and the pixels mapped to them are 0xRRGGBBAA with the alpha
+ * ignored, so a 'SPLCOL_HEX()' style 0xRRGGBB literal has to be shifted left
+ * by 8. Distances are plain squared differences of the RGB channels.
+ */
+
+/* Copies `colors_c` (1 to 256) `colors` into `pal` and builds its lookup
+ * table. Returns 0 on success or -1 on invalid `colors_c` or allocation
+ * failure. */
+SPLCOL_DEF int
+splcol_palette_init(splcol_palette *pal, const uint32_t *colors, int colors_c);
+
+/* Builds a palette of at most `colors_c` (1 to 256) colors for the `n` `px`
+ * pixels into `pal`, the same way as 'splcol_palette_init()'.
+ *
+ * The pixels are counted into a histogram of 5 bits per channel first, so the
+ * cost past that single pass does not depend on the image size. The histogram
+ * is split with median cut and the resulting colors are then refined with
+ * `kmeans_iters` k-means passes (0 to skip them, which stop early once no color
+ * moves).
+ *
+ * Fewer colors are produced if the image doesn't have as many distinct ones.
+ * Returns 0 on success or -1 on invalid arguments or allocation failure. */
+SPLCOL_DEF int
+splcol_palette_quantize(splcol_palette *pal, const uint32_t *px, size_t n,
+                        int colors_c, int kmeans_iters);
+
+/* Frees the lookup table of the palette. */
+SPLCOL_DEF void
+splcol_palette_free(splcol_palette *pal);
+
+/* Returns the index of the nearest palette color to `color` using the lookup
+ * table. The result is exact for the center of each 8x8x8 cell of the color
+ * cube and off by at most a cell for other colors. */
+SPLCOL_DEF int
+splcol_palette_lookup(const splcol_palette *pal, uint32_t color);
+
+/* Returns the index of the exact nearest palette color to `color` by checking
+ * every palette color. Prefer 'splcol_palette_lookup()' for images. */
+SPLCOL_DEF int
+splcol_palette_nearest(const splcol_palette *pal, uint32_t color);
+
+/* 'splcol_palette_lookup()' for `n` pixels, writing the indexes into `dst`. */
+SPLCOL_DEF void
+splcol_palette_map(const splcol_palette *pal, uint8_t *dst,
+                   const uint32_t *src, size_t n);
+
+/*
+ * = HEX STRINGS =
+ *
+ * Colors written as "#RGB", "#RGBA", "#RRGGBB" or "#RRGGBBAA" (the '#' being
+ * optional and the digits case insensitive) as found in stylesheets and JSON.
+ * Colors are 0xRRGGBBAA, opaque if the string has no alpha. All 8 digits are
+ * validated and converted at once in a uint64 instead of one by one.
+ */
+
+/* Parses the hex color string `str` into `*color`.
+ *
+ * `len` is the length of `str`; pass -1 if you want the function to calculate
+ * it. Returns 0 on success or -1 if the string is not a hex color, in which
+ * case `*color` is untouched. */
+SPLCOL_DEF int
+splcol_hex_parse(const char *str, int len, uint32_t *color);
+
+/* Parses `n` NUL-terminated `strs` into `dst`, invalid ones giving 0. If `ok`
+ * is non-NULL, `ok[i]` is set to 1 if `strs[i]` was valid and 0 otherwise.
+ *
+ * Returns the number of invalid strings. */
+SPLCOL_DEF size_t
+splcol_hex_parse_n(uint32_t *dst, uint8_t *ok, const char *const *strs,
+                   size_t n);
+
+/* Writes `color` as a NUL-terminated lowercase "#rrggbb" string into `buf`, or
+ * "#rrggbbaa" if `with_alpha` is non-zero. `buf` must hold 8 or 10 bytes
+ * respectively. */
+SPLCOL_DEF void
+splcol_hex_format(char *buf, uint32_t color, int with_alpha);
+
+/* 'splcol_hex_format()' for `n` `colors`, the strings being written one after
+ * the other 8 or 10 bytes apart in `buf`. */
+SPLCOL_DEF void
+splcol_hex_format_n(char *buf, const uint32_t *colors, size_t n,
+                    int with_alpha);
+
+/*
+ * = GRADIENTS =
+ */
+
+/* Fills `dst` with `n` 0xRRGGBBAA colors evenly spaced from position 0 to 1
+ * (both included) of the gradient made of the `stops_c` `stops`, interpolating
+ * in `space`.
+ *
+ * Stops must be sorted by position. Two stops at the same position make a hard
+ * edge and positions outside of the stops get the color of the nearest one.
+ * Alpha is always interpolated as it is. With no stops `dst` is zeroed. */
+SPLCOL_DEF void
+splcol_gradient(uint32_t *dst, size_t n, const splcol_gradient_stop *stops,
+                int stops_c, splcol_gradient_space space);
+
+/*
+ * = TERMINAL =
+ *
+ * Text and color changes are gathered in a buffer and written to the stream in
+ * large writes once it fills up or on 'splcol_term_flush()'. Colors are
+ * 0xRRGGBBAA and get reduced to what the mode supports: the nearest of the
+ * 6x6x6 cube and gray ramp colors for 256 colors and a lookup table for 16
+ * colors.
+ * Setting the color already in use writes nothing.
+ */
+
+/* Returns the mode fitting `stream`: no colors if it is not a terminal, $TERM
+ * is "dumb" or $NO_COLOR is set, truecolor if $COLORTERM says so and 256 or
+ * 16 colors from $TERM otherwise. Only stdout and stderr are checked for being
+ * a terminal. */
+SPLCOL_DEF splcol_term_mode
+splcol_term_detect(FILE *stream);
+
+/* Initializes `t` to write to `stream` in `mode` with a buffer of `buf_cap`
+ * bytes, 0 choosing 64 KiB. Returns 0 on success or -1 on allocation failure.
+ */
+SPLCOL_DEF int
+splcol_term_init(splcol_term *t, FILE *stream, splcol_term_mode mode,
+                 size_t buf_cap);
+
+/* Flushes and frees `t`. Returns the result of 'splcol_term_flush()'. */
+SPLCOL_DEF int
+splcol_term_free(splcol_term *t);
+
+/* Sets the foreground color of the following text. */
+SPLCOL_DEF void
+splcol_term_fg(splcol_term *t, uint32_t color);
+
+/* Sets the background color of the following text. */
+SPLCOL_DEF void
+splcol_term_bg(splcol_term *t, uint32_t color);
+
+/* Sets back the default foreground and background colors. */
+SPLCOL_DEF void
+splcol_term_reset(splcol_term *t);
+
+/* Writes `len` bytes of `str`. Pass -1 as `len` if you want the function to
+ * calculate it. */
+SPLCOL_DEF void
+splcol_term_write(splcol_term *t, const char *str, int len);
+
+/* Writes the formatted string, formatting directly into the buffer. */
+SPLCOL_DEF void
+splcol_term_printf(splcol_term *t, const char *fmt, ...);
+
+/* Writes out the buffer and flushes the stream. Returns 0 on success or -1 if
+ * this or any previous write failed. */
+SPLCOL_DEF int
+splcol_term_flush(splcol_term *t);
+
 #endif /* SPLCOL_H */
 
 /*
@@ -94,12 +514,2116 @@
 
 #ifdef SPLCOL_IMPL
 
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#if !defined(SPLCOL_NO_SIMD) && defined(__SSE2__)
+#define SPLCOL__SSE2
+#include <emmintrin.h>
+#endif
+
+#if !defined(SPLCOL_NO_SIMD) && defined(__AVX2__)
+#define SPLCOL__AVX2
+#include <immintrin.h>
+#endif
+
 /*
  ===============================================================================
  |                          Function Implementations                           |
  ===============================================================================
  */
 
+/* = BULK CONVERSION = */
+
+static uint32_t
+splcol__swap_rb(uint32_t p)
+{
+	return (p & 0x00FF00FF) | ((p >> 16) & 0x0000FF00) |
+	       ((p << 16) & 0xFF000000);
+}
+
+static uint16_t
+splcol__rgba_to_rgb565(uint32_t p)
+{
+	return (uint16_t)(((p >> 16) & 0xF800) | ((p >> 13) & 0x07E0) |
+	                  ((p >> 11) & 0x001F));
+}
+
+static uint32_t
+splcol__rgb565_to_rgba(uint32_t v)
+{
+	uint32_t r = v >> 11, g = (v >> 5) & 0x3F, b = v & 0x1F;
+
+	r = (r << 3) | (r >> 2);
+	g = (g << 2) | (g >> 4);
+	b = (b << 3) | (b >> 2);
+	return (r << 24) | (g << 16) | (b << 8) | 0xFF;
+}
+
+/* Clamps `v` to [0, 1] and rounds it to a uint8, NaN becoming 0. */
+static uint32_t
+splcol__unit_to_u8(float v)
+{
+	if (!(v > 0.0f))
+		return 0;
+	if (v >= 1.0f)
+		return 255;
+	return (uint32_t)(v * 255.0f + 0.5f);
+}
+
+#if defined(SPLCOL__SSE2) && !defined(SPLCOL__AVX2)
+static __m128i
+splcol__rgb565_to_rgba_sse2(__m128i v)
+{
+	const __m128i m5 = _mm_set1_epi32(0x1F), m6 = _mm_set1_epi32(0x3F);
+	__m128i       r, g, b;
+
+	r = _mm_srli_epi32(v, 11);
+	g = _mm_and_si128(_mm_srli_epi32(v, 5), m6);
+	b = _mm_and_si128(v, m5);
+	r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+	g = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4));
+	b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 24),
+	                                 _mm_slli_epi32(g, 16)),
+	                    _mm_or_si128(_mm_slli_epi32(b, 8),
+	                                 _mm_set1_epi32(0xFF)));
+}
+#endif
+
+#ifdef SPLCOL__SSE2
+static __m128i
+splcol__rgba_to_rgb565_sse2(__m128i p)
+{
+	return _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16),
+		                           _mm_set1_epi32(0xF800)),
+		             _mm_and_si128(_mm_srli_epi32(p, 13),
+		                           _mm_set1_epi32(0x07E0))),
+		_mm_and_si128(_mm_srli_epi32(p, 11), _mm_set1_epi32(0x001F)));
+}
+#endif /* SPLCOL__SSE2 */
+
+#ifdef SPLCOL__AVX2
+static __m256i
+splcol__pack_channels_avx2(__m256 r, __m256 g, __m256 b, __m256 a)
+{
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+	const __m256 k = _mm256_set1_ps(255.0f), half = _mm256_set1_ps(0.5f);
+
+	/* 'max' first so that NaN becomes 0 */
+#define SPLCOL__TO_U8(c)                                                 \
+	_mm256_cvttps_epi32(_mm256_add_ps(                               \
+		_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(c, zero), one), \
+		              k),                                         \
+		half))
+	__m256i ri = SPLCOL__TO_U8(r), gi = SPLCOL__TO_U8(g);
+	__m256i bi = SPLCOL__TO_U8(b), ai = SPLCOL__TO_U8(a);
+#undef SPLCOL__TO_U8
+
+	return _mm256_or_si256(
+		_mm256_or_si256(_mm256_slli_epi32(ri, 24),
+		                _mm256_slli_epi32(gi, 16)),
+		_mm256_or_si256(_mm256_slli_epi32(bi, 8), ai));
+}
+/* Loads 8 interleaved float pixels from `s` as channel planes. */
+static void
+splcol__load_planes_avx2(const float *s, __m256 *r, __m256 *g, __m256 *b,
+                         __m256 *a)
+{
+	__m128 r0, g0, b0, a0, r1, g1, b1, a1;
+
+	r0 = _mm_loadu_ps(s);
+	g0 = _mm_loadu_ps(s + 4);
+	b0 = _mm_loadu_ps(s + 8);
+	a0 = _mm_loadu_ps(s + 12);
+	r1 = _mm_loadu_ps(s + 16);
+	g1 = _mm_loadu_ps(s + 20);
+	b1 = _mm_loadu_ps(s + 24);
+	a1 = _mm_loadu_ps(s + 28);
+	_MM_TRANSPOSE4_PS(r0, g0, b0, a0);
+	_MM_TRANSPOSE4_PS(r1, g1, b1, a1);
+
+	*r = _mm256_insertf128_ps(_mm256_castps128_ps256(r0), r1, 1);
+	*g = _mm256_insertf128_ps(_mm256_castps128_ps256(g0), g1, 1);
+	*b = _mm256_insertf128_ps(_mm256_castps128_ps256(b0), b1, 1);
+	*a = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a1, 1);
+}
+
+/* Stores 8 pixels worth of channel planes into `d` as interleaved floats. */
+static void
+splcol__store_planes_avx2(float *d, __m256 r, __m256 g, __m256 b, __m256 a)
+{
+	for (int h = 0; h < 2; h++) {
+		__m128 r4 = h ? _mm256_extractf128_ps(r, 1) :
+		                _mm256_castps256_ps128(r);
+		__m128 g4 = h ? _mm256_extractf128_ps(g, 1) :
+		                _mm256_castps256_ps128(g);
+		__m128 b4 = h ? _mm256_extractf128_ps(b, 1) :
+		                _mm256_castps256_ps128(b);
+		__m128 a4 = h ? _mm256_extractf128_ps(a, 1) :
+		                _mm256_castps256_ps128(a);
+
+		_MM_TRANSPOSE4_PS(r4, g4, b4, a4);
+		_mm_storeu_ps(d + 16 * h, r4);
+		_mm_storeu_ps(d + 16 * h + 4, g4);
+		_mm_storeu_ps(d + 16 * h + 8, b4);
+		_mm_storeu_ps(d + 16 * h + 12, a4);
+	}
+}
+#endif /* SPLCOL__AVX2 */
+
+SPLCOL_DEF void
+splcol_swap_rb(uint32_t *dst, const uint32_t *src, size_t n)
+{
+	size_t i = 0;
+
+#if defined(SPLCOL__AVX2)
+	const __m256i keep = _mm256_set1_epi32(0x00FF00FF);
+	const __m256i m_b  = _mm256_set1_epi32(0x0000FF00);
+	const __m256i m_r  = _mm256_set1_epi32((int)0xFF000000);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i *)(src + i));
+		p = _mm256_or_si256(
+			_mm256_and_si256(p, keep),
+			_mm256_or_si256(
+				_mm256_and_si256(_mm256_srli_epi32(p, 16), m_b),
+				_mm256_and_si256(_mm256_slli_epi32(p, 16),
+			                         m_r)));
+		_mm256_storeu_si256((__m256i *)(dst + i), p);
+	}
+#elif defined(SPLCOL__SSE2)
+	const __m128i keep = _mm_set1_epi32(0x00FF00FF);
+	const __m128i m_b  = _mm_set1_epi32(0x0000FF00);
+	const __m128i m_r  = _mm_set1_epi32((int)0xFF000000);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+		p = _mm_or_si128(
+			_mm_and_si128(p, keep),
+			_mm_or_si128(
+				_mm_and_si128(_mm_srli_epi32(p, 16), m_b),
+				_mm_and_si128(_mm_slli_epi32(p, 16), m_r)));
+		_mm_storeu_si128((__m128i *)(dst + i), p);
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = splcol__swap_rb(src[i]);
+}
+
+SPLCOL_DEF void
+splcol_rgba_to_rgb565(uint16_t *dst, const uint32_t *src, size_t n)
+{
+	size_t i = 0;
+
+#ifdef SPLCOL__SSE2
+	/* 'packs' saturates signed values, so bias the 16 bit results into the
+	 * signed range and flip the bias back after packing */
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+		lo = _mm_sub_epi32(splcol__rgba_to_rgb565_sse2(lo), bias32);
+		hi = _mm_sub_epi32(splcol__rgba_to_rgb565_sse2(hi), bias32);
+		lo = _mm_xor_si128(_mm_packs_epi32(lo, hi), bias16);
+		_mm_storeu_si128((__m128i *)(dst + i), lo);
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = splcol__rgba_to_rgb565(src[i]);
+}
+
+SPLCOL_DEF void
+splcol_rgb565_to_rgba(uint32_t *dst, const uint16_t *src, size_t n)
+{
+	size_t i = 0;
+
+#if defined(SPLCOL__AVX2)
+	const __m256i m5 = _mm256_set1_epi32(0x1F);
+	const __m256i m6 = _mm256_set1_epi32(0x3F);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i v, r, g, b;
+
+		v = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i *)(src + i)));
+		r = _mm256_srli_epi32(v, 11);
+		g = _mm256_and_si256(_mm256_srli_epi32(v, 5), m6);
+		b = _mm256_and_si256(v, m5);
+		r = _mm256_or_si256(_mm256_slli_epi32(r, 3),
+		                    _mm256_srli_epi32(r, 2));
+		g = _mm256_or_si256(_mm256_slli_epi32(g, 2),
+		                    _mm256_srli_epi32(g, 4));
+		b = _mm256_or_si256(_mm256_slli_epi32(b, 3),
+		                    _mm256_srli_epi32(b, 2));
+		v = _mm256_or_si256(
+			_mm256_or_si256(_mm256_slli_epi32(r, 24),
+		                        _mm256_slli_epi32(g, 16)),
+			_mm256_or_si256(_mm256_slli_epi32(b, 8),
+		                        _mm256_set1_epi32(0xFF)));
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+#elif defined(SPLCOL__SSE2)
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+
+		_mm_storeu_si128((__m128i *)(dst + i),
+		                 splcol__rgb565_to_rgba_sse2(
+					 _mm_unpacklo_epi16(v, zero)));
+		_mm_storeu_si128((__m128i *)(dst + i + 4),
+		                 splcol__rgb565_to_rgba_sse2(
+					 _mm_unpackhi_epi16(v, zero)));
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = splcol__rgb565_to_rgba(src[i]);
+}
+
+SPLCOL_DEF void
+splcol_rgba_to_float(float *dst, const uint32_t *src, size_t n)
+{
+	const float k = 1.0f / 255.0f;
+	size_t      i = 0;
+
+#if defined(SPLCOL__AVX2)
+	const __m256i m  = _mm256_set1_epi32(0xFF);
+	const __m256  kv = _mm256_set1_ps(k);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256  r, g, b, a;
+
+		r = _mm256_cvtepi32_ps(_mm256_srli_epi32(p, 24));
+		g = _mm256_cvtepi32_ps(
+			_mm256_and_si256(_mm256_srli_epi32(p, 16), m));
+		b = _mm256_cvtepi32_ps(
+			_mm256_and_si256(_mm256_srli_epi32(p, 8), m));
+		a = _mm256_cvtepi32_ps(_mm256_and_si256(p, m));
+		r = _mm256_mul_ps(r, kv);
+		g = _mm256_mul_ps(g, kv);
+		b = _mm256_mul_ps(b, kv);
+		a = _mm256_mul_ps(a, kv);
+
+		splcol__store_planes_avx2(dst + 4 * i, r, g, b, a);
+	}
+#elif defined(SPLCOL__SSE2)
+	const __m128i m  = _mm_set1_epi32(0xFF);
+	const __m128  kv = _mm_set1_ps(k);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128  r, g, b, a;
+
+		r = _mm_cvtepi32_ps(_mm_srli_epi32(p, 24));
+		g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), m));
+		b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), m));
+		a = _mm_cvtepi32_ps(_mm_and_si128(p, m));
+		r = _mm_mul_ps(r, kv);
+		g = _mm_mul_ps(g, kv);
+		b = _mm_mul_ps(b, kv);
+		a = _mm_mul_ps(a, kv);
+
+		/* Channel planes to interleaved pixels */
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+		_mm_storeu_ps(dst + 4 * i, r);
+		_mm_storeu_ps(dst + 4 * i + 4, g);
+		_mm_storeu_ps(dst + 4 * i + 8, b);
+		_mm_storeu_ps(dst + 4 * i + 12, a);
+	}
+#endif
+
+	for (; i < n; i++) {
+		dst[4 * i + 0] = (float)((src[i] >> 24) & 0xFF) * k;
+		dst[4 * i + 1] = (float)((src[i] >> 16) & 0xFF) * k;
+		dst[4 * i + 2] = (float)((src[i] >> 8) & 0xFF) * k;
+		dst[4 * i + 3] = (float)(src[i] & 0xFF) * k;
+	}
+}
+
+SPLCOL_DEF void
+splcol_float_to_rgba(uint32_t *dst, const float *src, size_t n)
+{
+	size_t i = 0;
+
+#if defined(SPLCOL__AVX2)
+	for (; i + 8 <= n; i += 8) {
+		__m256 r, g, b, a;
+
+		splcol__load_planes_avx2(src + 4 * i, &r, &g, &b, &a);
+		_mm256_storeu_si256((__m256i *)(dst + i),
+		                    splcol__pack_channels_avx2(r, g, b, a));
+	}
+#elif defined(SPLCOL__SSE2)
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	const __m128 k = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128  r = _mm_loadu_ps(src + 4 * i);
+		__m128  g = _mm_loadu_ps(src + 4 * i + 4);
+		__m128  b = _mm_loadu_ps(src + 4 * i + 8);
+		__m128  a = _mm_loadu_ps(src + 4 * i + 12);
+		__m128i ri, gi, bi, ai;
+
+		/* Interleaved pixels to channel planes */
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+
+		/* 'max' first so that NaN becomes 0 */
+#define SPLCOL__TO_U8(c)                                                   \
+	_mm_cvttps_epi32(_mm_add_ps(                                       \
+		_mm_mul_ps(_mm_min_ps(_mm_max_ps(c, zero), one), k), half))
+		ri = SPLCOL__TO_U8(r);
+		gi = SPLCOL__TO_U8(g);
+		bi = SPLCOL__TO_U8(b);
+		ai = SPLCOL__TO_U8(a);
+#undef SPLCOL__TO_U8
+
+		_mm_storeu_si128(
+			(__m128i *)(dst + i),
+			_mm_or_si128(_mm_or_si128(_mm_slli_epi32(ri, 24),
+		                                  _mm_slli_epi32(gi, 16)),
+		                     _mm_or_si128(_mm_slli_epi32(bi, 8), ai)));
+	}
+#endif
+
+	for (; i < n; i++) {
+		dst[i] = (splcol__unit_to_u8(src[4 * i + 0]) << 24) |
+		         (splcol__unit_to_u8(src[4 * i + 1]) << 16) |
+		         (splcol__unit_to_u8(src[4 * i + 2]) << 8) |
+		         splcol__unit_to_u8(src[4 * i + 3]);
+	}
+}
+
+/* = SRGB = */
+
+/* Linear light value of every sRGB encoded channel */
+static const float splcol__srgb_dec[256] = {
+	0.0f, 0.000303526984f, 0.000607053967f, 0.000910580951f, 0.00121410793f,
+	0.00151763492f, 0.0018211619f, 0.00212468888f, 0.00242821587f,
+	0.00273174285f, 0.00303526984f, 0.00334653576f, 0.00367650732f,
+	0.00402471702f, 0.00439144204f, 0.00477695348f, 0.0051815167f,
+	0.00560539162f, 0.00604883302f, 0.00651209079f, 0.00699541019f,
+	0.00749903204f, 0.00802319299f, 0.00856812562f, 0.0091340587f,
+	0.00972121732f, 0.010329823f, 0.010960094f, 0.0116122452f,
+	0.0122864884f, 0.0129830323f, 0.013702083f, 0.0144438436f,
+	0.0152085144f, 0.0159962934f, 0.0168073758f, 0.0176419545f,
+	0.0185002201f, 0.019382361f, 0.0202885631f, 0.0212190104f,
+	0.0221738848f, 0.0231533662f, 0.0241576324f, 0.0251868596f,
+	0.0262412219f, 0.0273208916f, 0.0284260395f, 0.0295568344f,
+	0.0307134437f, 0.0318960331f, 0.0331047666f, 0.0343398068f,
+	0.0356013149f, 0.0368894504f, 0.0382043716f, 0.0395462353f,
+	0.0409151969f, 0.0423114106f, 0.0437350293f, 0.0451862044f,
+	0.0466650863f, 0.0481718242f, 0.049706566f, 0.0512694584f, 0.052860647f,
+	0.0544802764f, 0.05612849f, 0.0578054302f, 0.0595112382f, 0.0612460542f,
+	0.0630100177f, 0.0648032667f, 0.0666259386f, 0.0684781698f,
+	0.0703600957f, 0.0722718507f, 0.0742135684f, 0.0761853815f,
+	0.0781874218f, 0.0802198203f, 0.0822827071f, 0.0843762115f,
+	0.086500462f, 0.0886555863f, 0.0908417112f, 0.0930589628f,
+	0.0953074666f, 0.0975873471f, 0.0998987282f, 0.102241733f, 0.104616484f,
+	0.107023103f, 0.109461711f, 0.111932428f, 0.114435374f, 0.116970668f,
+	0.119538428f, 0.122138772f, 0.124771818f, 0.12743768f, 0.130136477f,
+	0.132868322f, 0.13563333f, 0.138431615f, 0.141263291f, 0.144128471f,
+	0.147027266f, 0.14995979f, 0.152926152f, 0.155926464f, 0.158960835f,
+	0.162029376f, 0.165132195f, 0.1682694f, 0.171441101f, 0.174647404f,
+	0.177888416f, 0.181164244f, 0.184474995f, 0.187820772f, 0.191201683f,
+	0.19461783f, 0.19806932f, 0.201556254f, 0.205078736f, 0.20863687f,
+	0.212230757f, 0.2158605f, 0.2195262f, 0.223227957f, 0.226965874f,
+	0.230740049f, 0.234550582f, 0.238397574f, 0.242281122f, 0.246201327f,
+	0.250158285f, 0.254152094f, 0.258182853f, 0.262250658f, 0.266355605f,
+	0.270497791f, 0.274677312f, 0.278894263f, 0.28314874f, 0.287440838f,
+	0.29177065f, 0.296138271f, 0.300543794f, 0.304987314f, 0.309468923f,
+	0.313988713f, 0.318546778f, 0.323143209f, 0.327778098f, 0.332451536f,
+	0.337163615f, 0.341914425f, 0.346704056f, 0.3515326f, 0.356400144f,
+	0.36130678f, 0.366252596f, 0.37123768f, 0.376262123f, 0.381326011f,
+	0.386429434f, 0.391572478f, 0.396755231f, 0.40197778f, 0.407240212f,
+	0.412542613f, 0.417885071f, 0.42326767f, 0.428690497f, 0.434153636f,
+	0.439657174f, 0.445201195f, 0.450785783f, 0.456411023f, 0.462077f,
+	0.467783796f, 0.473531496f, 0.479320183f, 0.48514994f, 0.49102085f,
+	0.496932995f, 0.502886458f, 0.508881321f, 0.514917665f, 0.520995573f,
+	0.527115126f, 0.533276404f, 0.539479489f, 0.545724461f, 0.552011402f,
+	0.55834039f, 0.564711506f, 0.571124829f, 0.57758044f, 0.584078418f,
+	0.590618841f, 0.597201788f, 0.603827339f, 0.610495571f, 0.617206562f,
+	0.623960392f, 0.630757136f, 0.637596874f, 0.644479682f, 0.651405637f,
+	0.658374817f, 0.665387298f, 0.672443157f, 0.67954247f, 0.686685312f,
+	0.693871761f, 0.701101892f, 0.70837578f, 0.715693501f, 0.723055129f,
+	0.73046074f, 0.737910409f, 0.74540421f, 0.752942217f, 0.760524505f,
+	0.768151147f, 0.775822218f, 0.783537792f, 0.79129794f, 0.799102738f,
+	0.806952258f, 0.814846572f, 0.822785754f, 0.830769877f, 0.838799012f,
+	0.846873232f, 0.854992608f, 0.863157213f, 0.871367119f, 0.879622397f,
+	0.887923118f, 0.896269353f, 0.904661174f, 0.913098652f, 0.921581856f,
+	0.930110858f, 0.938685728f, 0.947306537f, 0.955973353f, 0.964686248f,
+	0.97344529f, 0.98225055f, 0.991102097f, 1.0f,
+};
+
+/* 'bias << 16 | scale' of the linear segments approximating the sRGB curve, 8
+ * segments for every power of two in [2^-13, 1) */
+static const uint32_t splcol__srgb_enc[104] = {
+	0x0073000d, 0x007a000d, 0x0080000d, 0x0087000d, 0x008d000d, 0x0094000d,
+	0x009a000d, 0x00a1000d, 0x00a7001a, 0x00b4001a, 0x00c1001a, 0x00ce001a,
+	0x00da001a, 0x00e7001a, 0x00f4001a, 0x0101001a, 0x010e0033, 0x01280033,
+	0x01410033, 0x015b0033, 0x01750033, 0x018f0033, 0x01a80033, 0x01c20033,
+	0x01dc0067, 0x020f0067, 0x02430067, 0x02760067, 0x02aa0067, 0x02dd0067,
+	0x03110067, 0x03440067, 0x037800ce, 0x03df00ce, 0x044600ce, 0x04ad00ce,
+	0x051400ce, 0x057a00c5, 0x05dd00bc, 0x063b00b5, 0x06960158, 0x07420142,
+	0x07e30130, 0x087b0120, 0x090b0112, 0x09940106, 0x0a1700fc, 0x0a9500f2,
+	0x0b0e01cb, 0x0bf401ae, 0x0cca0195, 0x0d950180, 0x0e55016e, 0x0f0c015e,
+	0x0fbb0150, 0x10630143, 0x11060264, 0x1238023e, 0x1357021d, 0x14650201,
+	0x156601e9, 0x165a01d3, 0x174301c0, 0x182401af, 0x18fd0331, 0x1a9502fe,
+	0x1c1402d2, 0x1d7d02ad, 0x1ed3028d, 0x20190270, 0x21510256, 0x227c0240,
+	0x239e0443, 0x25bf03fe, 0x27be03c4, 0x29a00392, 0x2b690367, 0x2d1d0341,
+	0x2ebd031f, 0x304c0300, 0x31cf05b0, 0x34a70555, 0x37510507, 0x39d404c5,
+	0x3c36048b, 0x3e7b0458, 0x40a7042a, 0x42bc0401, 0x44c10798, 0x488c071e,
+	0x4c1a06b6, 0x4f75065d, 0x52a30610, 0x55ab05cc, 0x5890058f, 0x5b580559,
+	0x5e0a0a23, 0x631a0980, 0x67d908f6, 0x6c53087f, 0x70920818, 0x749e07bd,
+	0x787c076c, 0x7c310723,
+};
+
+/* Bit patterns of 2^-13, below which everything encodes to 0, and of the
+ * largest float below 1 */
+#define SPLCOL__SRGB_MIN 0x39000000u
+#define SPLCOL__SRGB_MAX 0x3F7FFFFFu
+
+#ifdef SPLCOL__AVX2
+static __m256i
+splcol__linear_to_srgb_avx2(__m256 v)
+{
+	const __m256i min = _mm256_set1_epi32((int)SPLCOL__SRGB_MIN);
+	const __m256i max = _mm256_set1_epi32((int)SPLCOL__SRGB_MAX);
+	__m256i       u, seg, bias, scale, t;
+
+	/* 'max' first so that NaN becomes the minimum */
+	v = _mm256_min_ps(_mm256_max_ps(v, _mm256_castsi256_ps(min)),
+	                  _mm256_castsi256_ps(max));
+	u = _mm256_castps_si256(v);
+
+	seg   = _mm256_i32gather_epi32(
+		(const int *)splcol__srgb_enc,
+		_mm256_srli_epi32(_mm256_sub_epi32(u, min), 20), 4);
+	bias  = _mm256_slli_epi32(_mm256_srli_epi32(seg, 16), 9);
+	scale = _mm256_and_si256(seg, _mm256_set1_epi32(0xFFFF));
+	t     = _mm256_and_si256(_mm256_srli_epi32(u, 12),
+	                         _mm256_set1_epi32(0xFF));
+
+	return _mm256_srli_epi32(
+		_mm256_add_epi32(bias, _mm256_mullo_epi32(scale, t)), 16);
+}
+#endif /* SPLCOL__AVX2 */
+
+SPLCOL_DEF float
+splcol_srgb_to_linear(uint8_t c)
+{
+	return splcol__srgb_dec[c];
+}
+
+SPLCOL_DEF uint8_t
+splcol_linear_to_srgb(float v)
+{
+	uint32_t u, seg, bias, scale, t;
+
+	memcpy(&u, &v, sizeof(u));
+
+	/* Compared as floats so that NaN fails the first test */
+	if (!(v > 0.0001220703125f))
+		u = SPLCOL__SRGB_MIN;
+	else if (u > SPLCOL__SRGB_MAX)
+		u = SPLCOL__SRGB_MAX;
+
+	seg   = splcol__srgb_enc[(u - SPLCOL__SRGB_MIN) >> 20];
+	bias  = (seg >> 16) << 9;
+	scale = seg & 0xFFFF;
+	t     = (u >> 12) & 0xFF;
+
+	return (uint8_t)((bias + scale * t) >> 16);
+}
+
+SPLCOL_DEF void
+splcol_srgb_to_linear_float(float *dst, const uint32_t *src, size_t n)
+{
+	const float k = 1.0f / 255.0f;
+	size_t      i = 0;
+
+#ifdef SPLCOL__AVX2
+	const __m256i m = _mm256_set1_epi32(0xFF);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256  r, g, b, a;
+
+		r = _mm256_i32gather_ps(splcol__srgb_dec,
+		                        _mm256_srli_epi32(p, 24), 4);
+		g = _mm256_i32gather_ps(
+			splcol__srgb_dec,
+			_mm256_and_si256(_mm256_srli_epi32(p, 16), m), 4);
+		b = _mm256_i32gather_ps(
+			splcol__srgb_dec,
+			_mm256_and_si256(_mm256_srli_epi32(p, 8), m), 4);
+		a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(p, m)),
+		                  _mm256_set1_ps(k));
+		splcol__store_planes_avx2(dst + 4 * i, r, g, b, a);
+	}
+#endif
+
+	for (; i < n; i++) {
+		dst[4 * i + 0] = splcol__srgb_dec[(src[i] >> 24) & 0xFF];
+		dst[4 * i + 1] = splcol__srgb_dec[(src[i] >> 16) & 0xFF];
+		dst[4 * i + 2] = splcol__srgb_dec[(src[i] >> 8) & 0xFF];
+		dst[4 * i + 3] = (float)(src[i] & 0xFF) * k;
+	}
+}
+
+SPLCOL_DEF void
+splcol_linear_float_to_srgb(uint32_t *dst, const float *src, size_t n)
+{
+	size_t i = 0;
+
+#ifdef SPLCOL__AVX2
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (; i + 8 <= n; i += 8) {
+		__m256  r, g, b, a;
+		__m256i ri, gi, bi, p;
+
+		splcol__load_planes_avx2(src + 4 * i, &r, &g, &b, &a);
+
+		ri = splcol__linear_to_srgb_avx2(r);
+		gi = splcol__linear_to_srgb_avx2(g);
+		bi = splcol__linear_to_srgb_avx2(b);
+
+		/* Alpha alone goes through the plain quantization */
+		p = _mm256_or_si256(
+			_mm256_or_si256(_mm256_slli_epi32(ri, 24),
+		                        _mm256_slli_epi32(gi, 16)),
+			_mm256_or_si256(_mm256_slli_epi32(bi, 8),
+		                        splcol__pack_channels_avx2(zero, zero,
+		                                                   zero, a)));
+		_mm256_storeu_si256((__m256i *)(dst + i), p);
+	}
+#endif
+
+	for (; i < n; i++) {
+		const float *c = src + 4 * i;
+
+		dst[i] = ((uint32_t)splcol_linear_to_srgb(c[0]) << 24) |
+		         ((uint32_t)splcol_linear_to_srgb(c[1]) << 16) |
+		         ((uint32_t)splcol_linear_to_srgb(c[2]) << 8) |
+		         splcol__unit_to_u8(c[3]);
+	}
+}
+
+/* = COMPOSITING = */
+
+/* 'ceil(255 * 2^16 / a)', which makes the rounded 'c * 255 / a' of
+ * 'splcol_unpremultiply()' exact for every 'c <= a' */
+static const uint32_t splcol__unpremul_recip[256] = {
+	0x00000000, 0x00ff0000, 0x007f8000, 0x00550000, 0x003fc000, 0x00330000,
+	0x002a8000, 0x00246db7, 0x001fe000, 0x001c5556, 0x00198000, 0x00172e8c,
+	0x00154000, 0x00139d8a, 0x001236dc, 0x00110000, 0x000ff000, 0x000f0000,
+	0x000e2aab, 0x000d6bcb, 0x000cc000, 0x000c2493, 0x000b9746, 0x000b1643,
+	0x000aa000, 0x000a3334, 0x0009cec5, 0x000971c8, 0x00091b6e, 0x0008cb09,
+	0x00088000, 0x000839cf, 0x0007f800, 0x0007ba2f, 0x00078000, 0x00074925,
+	0x00071556, 0x0006e454, 0x0006b5e6, 0x000689d9, 0x00066000, 0x00063832,
+	0x0006124a, 0x0005ee24, 0x0005cba3, 0x0005aaab, 0x00058b22, 0x00056cf0,
+	0x00055000, 0x0005343f, 0x0005199a, 0x00050000, 0x0004e763, 0x0004cfb3,
+	0x0004b8e4, 0x0004a2e9, 0x00048db7, 0x00047944, 0x00046585, 0x00045271,
+	0x00044000, 0x00042e2a, 0x00041ce8, 0x00040c31, 0x0003fc00, 0x0003ec4f,
+	0x0003dd18, 0x0003ce55, 0x0003c000, 0x0003b217, 0x0003a493, 0x00039770,
+	0x00038aab, 0x00037e40, 0x0003722a, 0x00036667, 0x00035af3, 0x00034fcb,
+	0x000344ed, 0x00033a55, 0x00033000, 0x000325ee, 0x00031c19, 0x00031282,
+	0x00030925, 0x00030000, 0x0002f712, 0x0002ee59, 0x0002e5d2, 0x0002dd7c,
+	0x0002d556, 0x0002cd5d, 0x0002c591, 0x0002bdf0, 0x0002b678, 0x0002af29,
+	0x0002a800, 0x0002a0fe, 0x00029a20, 0x00029365, 0x00028ccd, 0x00028657,
+	0x00028000, 0x000279ca, 0x000273b2, 0x00026db7, 0x000267da, 0x00026218,
+	0x00025c72, 0x000256e7, 0x00025175, 0x00024c1c, 0x000246dc, 0x000241b3,
+	0x00023ca2, 0x000237a7, 0x000232c3, 0x00022df3, 0x00022939, 0x00022493,
+	0x00022000, 0x00021b82, 0x00021715, 0x000212bc, 0x00020e74, 0x00020a3e,
+	0x00020619, 0x00020205, 0x0001fe00, 0x0001fa0c, 0x0001f628, 0x0001f253,
+	0x0001ee8c, 0x0001ead4, 0x0001e72b, 0x0001e38f, 0x0001e000, 0x0001dc80,
+	0x0001d90c, 0x0001d5a4, 0x0001d24a, 0x0001cefb, 0x0001cbb8, 0x0001c881,
+	0x0001c556, 0x0001c235, 0x0001bf20, 0x0001bc15, 0x0001b915, 0x0001b61f,
+	0x0001b334, 0x0001b052, 0x0001ad7a, 0x0001aaab, 0x0001a7e6, 0x0001a52a,
+	0x0001a277, 0x00019fcc, 0x00019d2b, 0x00019a91, 0x00019800, 0x00019578,
+	0x000192f7, 0x0001907e, 0x00018e0d, 0x00018ba3, 0x00018941, 0x000186e6,
+	0x00018493, 0x00018246, 0x00018000, 0x00017dc2, 0x00017b89, 0x00017958,
+	0x0001772d, 0x00017508, 0x000172e9, 0x000170d1, 0x00016ebe, 0x00016cb2,
+	0x00016aab, 0x000168aa, 0x000166af, 0x000164b9, 0x000162c9, 0x000160de,
+	0x00015ef8, 0x00015d18, 0x00015b3c, 0x00015966, 0x00015795, 0x000155c8,
+	0x00015400, 0x0001523e, 0x0001507f, 0x00014ec5, 0x00014d10, 0x00014b5f,
+	0x000149b3, 0x0001480b, 0x00014667, 0x000144c7, 0x0001432c, 0x00014194,
+	0x00014000, 0x00013e71, 0x00013ce5, 0x00013b5d, 0x000139d9, 0x00013859,
+	0x000136dc, 0x00013563, 0x000133ed, 0x0001327b, 0x0001310c, 0x00012fa1,
+	0x00012e39, 0x00012cd5, 0x00012b74, 0x00012a16, 0x000128bb, 0x00012763,
+	0x0001260e, 0x000124bd, 0x0001236e, 0x00012223, 0x000120da, 0x00011f94,
+	0x00011e51, 0x00011d11, 0x00011bd4, 0x00011a99, 0x00011962, 0x0001182c,
+	0x000116fa, 0x000115ca, 0x0001149d, 0x00011372, 0x0001124a, 0x00011124,
+	0x00011000, 0x00010ee0, 0x00010dc1, 0x00010ca5, 0x00010b8b, 0x00010a73,
+	0x0001095e, 0x0001084b, 0x0001073a, 0x0001062c, 0x0001051f, 0x00010415,
+	0x0001030d, 0x00010207, 0x00010103, 0x00010000,
+};
+
+/* Rounded `x / 255`, exact for every `x <= 255 * 255` */
+static uint32_t
+splcol__div255(uint32_t x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+static uint32_t
+splcol__blend(uint32_t d, uint32_t s, splcol_blend_mode mode)
+{
+	uint32_t sa = s & 0xFF, da = d & 0xFF, out = 0;
+
+	/* Alpha goes through the same formula as the colors: for valid
+	 * premultiplied pixels it gives the expected alpha of each mode */
+	for (int sh = 0; sh < 32; sh += 8) {
+		uint32_t sc = (s >> sh) & 0xFF, dc = (d >> sh) & 0xFF, c;
+
+		if (mode == SPLCOL_BLEND_OVER)
+			c = sc + splcol__div255(dc * (255 - sa));
+		else if (mode == SPLCOL_BLEND_ADD)
+			c = sc + dc;
+		else
+			c = splcol__div255(sc * dc + sc * (255 - da) +
+			                   dc * (255 - sa));
+		out |= (c > 255 ? 255 : c) << sh;
+	}
+
+	return out;
+}
+
+#ifdef SPLCOL__SSE2
+/* 'splcol__div255()' on 16 bit lanes, saturating to 255 instead of wrapping */
+static __m128i
+splcol__div255_sse2(__m128i x)
+{
+	x = _mm_adds_epu16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_adds_epu16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/* Broadcasts the alpha of the 2 pixels unpacked into the 16 bit lanes of `x`
+ * to all of their lanes */
+static __m128i
+splcol__alpha16_sse2(__m128i x)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0x00), 0x00);
+}
+
+/* 'splcol__blend()' for over and multiply on 2 pixels unpacked into 16 bit
+ * lanes. The result is packed with unsigned saturation. */
+static __m128i
+splcol__blend16_sse2(__m128i d, __m128i s, splcol_blend_mode mode)
+{
+	const __m128i full = _mm_set1_epi16(255);
+	__m128i       isa  = _mm_sub_epi16(full, splcol__alpha16_sse2(s));
+	__m128i       ida, x;
+
+	if (mode == SPLCOL_BLEND_OVER)
+		return _mm_add_epi16(
+			s, splcol__div255_sse2(_mm_mullo_epi16(d, isa)));
+
+	ida = _mm_sub_epi16(full, splcol__alpha16_sse2(d));
+	x   = _mm_adds_epu16(_mm_mullo_epi16(s, d), _mm_mullo_epi16(s, ida));
+	x   = _mm_adds_epu16(x, _mm_mullo_epi16(d, isa));
+	return splcol__div255_sse2(x);
+}
+#endif /* SPLCOL__SSE2 */
+
+SPLCOL_DEF void
+splcol_blend(uint32_t *dst, const uint32_t *src, size_t n,
+             splcol_blend_mode mode)
+{
+	size_t i = 0;
+
+	if (mode != SPLCOL_BLEND_OVER && mode != SPLCOL_BLEND_ADD &&
+	    mode != SPLCOL_BLEND_MULTIPLY)
+		return;
+
+#ifdef SPLCOL__SSE2
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xFF);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+		int     clear, opaq;
+
+		/* Fully transparent and opaque sources are common around UI
+		 * elements and need no blending */
+		clear = _mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF;
+		opaq  = _mm_movemask_epi8(_mm_cmpeq_epi32(
+				_mm_and_si128(s, opaque), opaque)) == 0xFFFF;
+
+		if (mode == SPLCOL_BLEND_ADD) {
+			d = _mm_adds_epu8(d, s);
+		} else if (mode == SPLCOL_BLEND_OVER && clear) {
+			continue;
+		} else if (mode == SPLCOL_BLEND_OVER && opaq) {
+			d = s;
+		} else {
+			d = _mm_packus_epi16(
+				splcol__blend16_sse2(_mm_unpacklo_epi8(d, zero),
+			                             _mm_unpacklo_epi8(s, zero),
+			                             mode),
+				splcol__blend16_sse2(_mm_unpackhi_epi8(d, zero),
+			                             _mm_unpackhi_epi8(s, zero),
+			                             mode));
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = splcol__blend(dst[i], src[i], mode);
+}
+
+SPLCOL_DEF void
+splcol_blend_straight(uint32_t *dst, const uint32_t *src, size_t n,
+                      splcol_blend_mode mode)
+{
+	uint32_t s[256], d[256];
+
+	for (size_t i = 0; i < n; i += 256) {
+		size_t c = n - i < 256 ? n - i : 256;
+
+		splcol_premultiply(s, src + i, c);
+		splcol_premultiply(d, dst + i, c);
+		splcol_blend(d, s, c, mode);
+		splcol_unpremultiply(dst + i, d, c);
+	}
+}
+
+SPLCOL_DEF void
+splcol_premultiply(uint32_t *dst, const uint32_t *src, size_t n)
+{
+	size_t i = 0;
+
+#ifdef SPLCOL__SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ma   = _mm_set1_epi32(0xFF);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i p  = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_unpacklo_epi8(p, zero);
+		__m128i hi = _mm_unpackhi_epi8(p, zero);
+
+		lo = splcol__div255_sse2(
+			_mm_mullo_epi16(lo, splcol__alpha16_sse2(lo)));
+		hi = splcol__div255_sse2(
+			_mm_mullo_epi16(hi, splcol__alpha16_sse2(hi)));
+
+		/* Put back the alpha which got multiplied by itself */
+		p = _mm_or_si128(_mm_andnot_si128(ma, _mm_packus_epi16(lo, hi)),
+		                 _mm_and_si128(p, ma));
+		_mm_storeu_si128((__m128i *)(dst + i), p);
+	}
+#endif
+
+	for (; i < n; i++) {
+		uint32_t p = src[i], a = p & 0xFF;
+
+		dst[i] = (splcol__div255((p >> 24) * a) << 24) |
+		         (splcol__div255(((p >> 16) & 0xFF) * a) << 16) |
+		         (splcol__div255(((p >> 8) & 0xFF) * a) << 8) | a;
+	}
+}
+
+SPLCOL_DEF void
+splcol_unpremultiply(uint32_t *dst, const uint32_t *src, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		uint32_t p = src[i], a = p & 0xFF, out = a;
+		uint32_t r = splcol__unpremul_recip[a];
+
+		/* No SIMD version: there is no 8-lane table lookup in SSE2 and
+		 * this is only needed once per layer */
+		for (int sh = 8; sh < 32; sh += 8) {
+			uint32_t c = (((p >> sh) & 0xFF) * r + 32768) >> 16;
+			out |= (c > 255 ? 255 : c) << sh;
+		}
+		dst[i] = out;
+	}
+}
+
+/* = COLOR SPACES = */
+
+static float
+splcol__minf(float a, float b)
+{
+	return a < b ? a : b;
+}
+
+static float
+splcol__maxf(float a, float b)
+{
+	return a > b ? a : b;
+}
+
+/* `x - floor(x)`, without libm */
+static float
+splcol__fract(float x)
+{
+	float t = (float)(int)x;
+
+	return x - (t > x ? t - 1.0f : t);
+}
+
+/* Cube root without libm: a bit trick first guess refined by Newton's method,
+ * accurate to a float ulp or two. Zero, denormals and NaN give 0. */
+static float
+splcol__cbrt(float x)
+{
+	float    a = x < 0 ? -x : x, y;
+	uint32_t u;
+
+	if (!(a > 1e-30f))
+		return 0.0f;
+
+	memcpy(&u, &a, sizeof(u));
+	u = u / 3 + 0x2A514067;
+	memcpy(&y, &u, sizeof(y));
+	for (int k = 0; k < 3; k++)
+		y = (2.0f * y + a / (y * y)) * (1.0f / 3.0f);
+
+	return x < 0 ? -y : y;
+}
+
+/* Hue of the RGB color with the given maximum and chroma `d`, 0 if gray */
+static float
+splcol__hue(float r, float g, float b, float mx, float d)
+{
+	float h;
+
+	if (!(d > 0))
+		return 0.0f;
+
+	if (mx == r)
+		h = (g - b) / d;
+	else if (mx == g)
+		h = (b - r) / d + 2.0f;
+	else
+		h = (r - g) / d + 4.0f;
+	h *= 1.0f / 6.0f;
+
+	return h < 0 ? h + 1.0f : h;
+}
+
+SPLCOL_DEF void
+splcol_rgb_to_hsv(float r, float g, float b, float *h, float *s, float *v)
+{
+	float mx = splcol__maxf(splcol__maxf(r, g), b);
+	float mn = splcol__minf(splcol__minf(r, g), b);
+
+	*h = splcol__hue(r, g, b, mx, mx - mn);
+	*s = mx > 0 ? (mx - mn) / mx : 0.0f;
+	*v = mx;
+}
+
+/* One channel of 'splcol_hsv_to_rgb()', `k0` being 5, 3 or 1 for red, green
+ * or blue */
+static float
+splcol__hsv_ch(float k0, float h6, float s, float v)
+{
+	float k = k0 + h6, t;
+
+	if (k >= 6.0f)
+		k -= 6.0f;
+	t = splcol__minf(splcol__minf(k, 4.0f - k), 1.0f);
+
+	return v - v * s * splcol__maxf(t, 0.0f);
+}
+
+SPLCOL_DEF void
+splcol_hsv_to_rgb(float h, float s, float v, float *r, float *g, float *b)
+{
+	float h6 = splcol__fract(h) * 6.0f;
+
+	*r = splcol__hsv_ch(5.0f, h6, s, v);
+	*g = splcol__hsv_ch(3.0f, h6, s, v);
+	*b = splcol__hsv_ch(1.0f, h6, s, v);
+}
+
+SPLCOL_DEF void
+splcol_rgb_to_hsl(float r, float g, float b, float *h, float *s, float *l)
+{
+	float mx = splcol__maxf(splcol__maxf(r, g), b);
+	float mn = splcol__minf(splcol__minf(r, g), b);
+	float d = mx - mn, t = mx + mn - 1.0f;
+
+	t  = 1.0f - (t < 0 ? -t : t);
+	*h = splcol__hue(r, g, b, mx, d);
+	*s = d > 0 && t > 0 ? d / t : 0.0f;
+	*l = (mx + mn) * 0.5f;
+}
+
+/* One channel of 'splcol_hsl_to_rgb()', `k0` being 0, 8 or 4 for red, green
+ * or blue and `a` the chroma over 2 */
+static float
+splcol__hsl_ch(float k0, float h12, float a, float l)
+{
+	float k = k0 + h12, t;
+
+	if (k >= 12.0f)
+		k -= 12.0f;
+	t = splcol__minf(splcol__minf(k - 3.0f, 9.0f - k), 1.0f);
+
+	return l - a * splcol__maxf(t, -1.0f);
+}
+
+SPLCOL_DEF void
+splcol_hsl_to_rgb(float h, float s, float l, float *r, float *g, float *b)
+{
+	float h12 = splcol__fract(h) * 12.0f;
+	float a   = s * splcol__minf(l, 1.0f - l);
+
+	*r = splcol__hsl_ch(0.0f, h12, a, l);
+	*g = splcol__hsl_ch(8.0f, h12, a, l);
+	*b = splcol__hsl_ch(4.0f, h12, a, l);
+}
+
+/* Matrices from Björn Ottosson, "A perceptual color space for image
+ * processing" https://bottosson.github.io/posts/oklab/ */
+
+SPLCOL_DEF void
+splcol_rgb_to_oklab(float r, float g, float b, float *l, float *a, float *bb)
+{
+	float l_ = 0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b;
+	float m_ = 0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b;
+	float s_ = 0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b;
+
+	l_ = splcol__cbrt(l_);
+	m_ = splcol__cbrt(m_);
+	s_ = splcol__cbrt(s_);
+
+	*l  = 0.2104542553f * l_ + 0.7936177850f * m_ - 0.0040720468f * s_;
+	*a  = 1.9779984951f * l_ - 2.4285922050f * m_ + 0.4505937099f * s_;
+	*bb = 0.0259040371f * l_ + 0.7827717662f * m_ - 0.8086757660f * s_;
+}
+
+SPLCOL_DEF void
+splcol_oklab_to_rgb(float l, float a, float bb, float *r, float *g, float *b)
+{
+	float l_ = l + 0.3963377774f * a + 0.2158037573f * bb;
+	float m_ = l - 0.1055613458f * a - 0.0638541728f * bb;
+	float s_ = l - 0.0894841775f * a - 1.2914855480f * bb;
+
+	l_ = l_ * l_ * l_;
+	m_ = m_ * m_ * m_;
+	s_ = s_ * s_ * s_;
+
+	*r = 4.0767416621f * l_ - 3.3077115913f * m_ + 0.2309699292f * s_;
+	*g = -1.2684380046f * l_ + 2.6097574011f * m_ - 0.3413193965f * s_;
+	*b = -0.0041960863f * l_ - 0.7034186147f * m_ + 1.7076147010f * s_;
+}
+
+#ifdef SPLCOL__SSE2
+static __m128
+splcol__select_sse2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static __m128
+splcol__fract_sse2(__m128 x)
+{
+	__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+
+	t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+	return _mm_sub_ps(x, t);
+}
+
+static __m128
+splcol__cbrt_sse2(__m128 x)
+{
+	const __m128 sign  = _mm_set1_ps(-0.0f);
+	const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+	__m128       a     = _mm_andnot_ps(sign, x), y;
+
+	/* 'u / 3' of the first guess through floats, exact enough for it */
+	y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_castps_si128(a)), third);
+	y = _mm_castsi128_ps(_mm_add_epi32(_mm_cvttps_epi32(y),
+	                                   _mm_set1_epi32(0x2A514067)));
+	for (int k = 0; k < 3; k++)
+		y = _mm_mul_ps(_mm_add_ps(_mm_add_ps(y, y),
+		                          _mm_div_ps(a, _mm_mul_ps(y, y))),
+		               third);
+
+	y = _mm_and_ps(_mm_cmpgt_ps(a, _mm_set1_ps(1e-30f)), y);
+	return _mm_or_ps(y, _mm_and_ps(sign, x));
+}
+
+static __m128
+splcol__hue_sse2(__m128 r, __m128 g, __m128 b, __m128 mx, __m128 d)
+{
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	__m128       rd   = _mm_div_ps(one, d), h;
+
+	h = splcol__select_sse2(
+		_mm_cmpeq_ps(mx, r), _mm_mul_ps(_mm_sub_ps(g, b), rd),
+		splcol__select_sse2(
+			_mm_cmpeq_ps(mx, g),
+			_mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, r), rd),
+		                   _mm_set1_ps(2.0f)),
+			_mm_add_ps(_mm_mul_ps(_mm_sub_ps(r, g), rd),
+		                   _mm_set1_ps(4.0f))));
+	h = _mm_mul_ps(h, _mm_set1_ps(1.0f / 6.0f));
+	h = _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, zero), one));
+
+	return _mm_and_ps(_mm_cmpgt_ps(d, zero), h);
+}
+
+static void
+splcol__rgb_to_hsv_sse2(__m128 *c0, __m128 *c1, __m128 *c2)
+{
+	__m128 mx = _mm_max_ps(_mm_max_ps(*c0, *c1), *c2);
+	__m128 mn = _mm_min_ps(_mm_min_ps(*c0, *c1), *c2);
+	__m128 d  = _mm_sub_ps(mx, mn);
+
+	*c0 = splcol__hue_sse2(*c0, *c1, *c2, mx, d);
+	*c1 = _mm_and_ps(_mm_cmpgt_ps(mx, _mm_setzero_ps()), _mm_div_ps(d, mx));
+	*c2 = mx;
+}
+
+static __m128
+splcol__hsv_ch_sse2(float k0, __m128 h6, __m128 vs, __m128 v)
+{
+	const __m128 six = _mm_set1_ps(6.0f);
+	__m128       k   = _mm_add_ps(_mm_set1_ps(k0), h6), t;
+
+	k = _mm_sub_ps(k, _mm_and_ps(_mm_cmpge_ps(k, six), six));
+	t = _mm_min_ps(_mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4.0f), k)),
+	               _mm_set1_ps(1.0f));
+
+	return _mm_sub_ps(v, _mm_mul_ps(vs, _mm_max_ps(t, _mm_setzero_ps())));
+}
+
+static void
+splcol__hsv_to_rgb_sse2(__m128 *c0, __m128 *c1, __m128 *c2)
+{
+	__m128 h6 = _mm_mul_ps(splcol__fract_sse2(*c0), _mm_set1_ps(6.0f));
+	__m128 vs = _mm_mul_ps(*c2, *c1), v = *c2;
+
+	*c0 = splcol__hsv_ch_sse2(5.0f, h6, vs, v);
+	*c1 = splcol__hsv_ch_sse2(3.0f, h6, vs, v);
+	*c2 = splcol__hsv_ch_sse2(1.0f, h6, vs, v);
+}
+
+static void
+splcol__rgb_to_hsl_sse2(__m128 *c0, __m128 *c1, __m128 *c2)
+{
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	__m128       mx   = _mm_max_ps(_mm_max_ps(*c0, *c1), *c2);
+	__m128       mn   = _mm_min_ps(_mm_min_ps(*c0, *c1), *c2);
+	__m128       d = _mm_sub_ps(mx, mn), sum = _mm_add_ps(mx, mn), t;
+
+	t = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(sum, one));
+	t = _mm_sub_ps(one, t);
+
+	*c0 = splcol__hue_sse2(*c0, *c1, *c2, mx, d);
+	*c1 = _mm_and_ps(_mm_cmpgt_ps(d, zero), _mm_cmpgt_ps(t, zero));
+	*c1 = _mm_and_ps(*c1, _mm_div_ps(d, t));
+	*c2 = _mm_mul_ps(sum, _mm_set1_ps(0.5f));
+}
+
+static __m128
+splcol__hsl_ch_sse2(float k0, __m128 h12, __m128 a, __m128 l)
+{
+	const __m128 twelve = _mm_set1_ps(12.0f);
+	__m128       k      = _mm_add_ps(_mm_set1_ps(k0), h12), t;
+
+	k = _mm_sub_ps(k, _mm_and_ps(_mm_cmpge_ps(k, twelve), twelve));
+	t = _mm_min_ps(_mm_min_ps(_mm_sub_ps(k, _mm_set1_ps(3.0f)),
+	                          _mm_sub_ps(_mm_set1_ps(9.0f), k)),
+	               _mm_set1_ps(1.0f));
+
+	return _mm_sub_ps(l, _mm_mul_ps(a, _mm_max_ps(t, _mm_set1_ps(-1.0f))));
+}
+
+static void
+splcol__hsl_to_rgb_sse2(__m128 *c0, __m128 *c1, __m128 *c2)
+{
+	const __m128 one = _mm_set1_ps(1.0f), twelve = _mm_set1_ps(12.0f);
+	__m128       h12 = _mm_mul_ps(splcol__fract_sse2(*c0), twelve);
+	__m128       l   = *c2;
+	__m128       a   = _mm_mul_ps(*c1, _mm_min_ps(l, _mm_sub_ps(one, l)));
+
+	*c0 = splcol__hsl_ch_sse2(0.0f, h12, a, l);
+	*c1 = splcol__hsl_ch_sse2(8.0f, h12, a, l);
+	*c2 = splcol__hsl_ch_sse2(4.0f, h12, a, l);
+}
+
+/* Row `m` of a 3x3 matrix times the column (x, y, z) */
+#define SPLCOL__DOT3(m, x, y, z)                                    \
+	_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps((m)[0]), x),   \
+	                      _mm_mul_ps(_mm_set1_ps((m)[1]), y)), \
+	           _mm_mul_ps(_mm_set1_ps((m)[2]), z))
+
+static void
+splcol__rgb_to_oklab_sse2(__m128 *c0, __m128 *c1, __m128 *c2)
+{
+	static const float m1[3][3] = {
+		{ 0.4122214708f, 0.5363325363f, 0.0514459929f },
+		{ 0.2119034982f, 0.6806995451f, 0.1073969566f },
+		{ 0.0883024619f, 0.2817188376f, 0.6299787005f },
+	};
+	static const float m2[3][3] = {
+		{ 0.2104542553f, 0.7936177850f, -0.0040720468f },
+		{ 1.9779984951f, -2.4285922050f, 0.4505937099f },
+		{ 0.0259040371f, 0.7827717662f, -0.8086757660f },
+	};
+	__m128 l = splcol__cbrt_sse2(SPLCOL__DOT3(m1[0], *c0, *c1, *c2));
+	__m128 m = splcol__cbrt_sse2(SPLCOL__DOT3(m1[1], *c0, *c1, *c2));
+	__m128 s = splcol__cbrt_sse2(SPLCOL__DOT3(m1[2], *c0, *c1, *c2));
+
+	*c0 = SPLCOL__DOT3(m2[0], l, m, s);
+	*c1 = SPLCOL__DOT3(m2[1], l, m, s);
+	*c2 = SPLCOL__DOT3(m2[2], l, m, s);
+}
+
+static void
+splcol__oklab_to_rgb_sse2(__m128 *c0, __m128 *c1, __m128 *c2)
+{
+	static const float m1[3][3] = {
+		{ 1.0f, 0.3963377774f, 0.2158037573f },
+		{ 1.0f, -0.1055613458f, -0.0638541728f },
+		{ 1.0f, -0.0894841775f, -1.2914855480f },
+	};
+	static const float m2[3][3] = {
+		{ 4.0767416621f, -3.3077115913f, 0.2309699292f },
+		{ -1.2684380046f, 2.6097574011f, -0.3413193965f },
+		{ -0.0041960863f, -0.7034186147f, 1.7076147010f },
+	};
+	__m128 l = SPLCOL__DOT3(m1[0], *c0, *c1, *c2);
+	__m128 m = SPLCOL__DOT3(m1[1], *c0, *c1, *c2);
+	__m128 s = SPLCOL__DOT3(m1[2], *c0, *c1, *c2);
+
+	l = _mm_mul_ps(_mm_mul_ps(l, l), l);
+	m = _mm_mul_ps(_mm_mul_ps(m, m), m);
+	s = _mm_mul_ps(_mm_mul_ps(s, s), s);
+
+	*c0 = SPLCOL__DOT3(m2[0], l, m, s);
+	*c1 = SPLCOL__DOT3(m2[1], l, m, s);
+	*c2 = SPLCOL__DOT3(m2[2], l, m, s);
+}
+
+#undef SPLCOL__DOT3
+
+/* Runs `kernel` on 4 pixels at a time of the input channel arrays `i0`, `i1`
+ * and `i2`, writing into `o0`, `o1` and `o2` */
+#define SPLCOL__SOA_SSE2(kernel, o0, o1, o2, i0, i1, i2)      \
+	for (; i + 4 <= n; i += 4) {                          \
+		__m128 c0 = _mm_loadu_ps(i0 + i);             \
+		__m128 c1 = _mm_loadu_ps(i1 + i);             \
+		__m128 c2 = _mm_loadu_ps(i2 + i);             \
+                                                              \
+		kernel(&c0, &c1, &c2);                        \
+		_mm_storeu_ps(o0 + i, c0);                    \
+		_mm_storeu_ps(o1 + i, c1);                    \
+		_mm_storeu_ps(o2 + i, c2);                    \
+	}
+#else
+#define SPLCOL__SOA_SSE2(kernel, o0, o1, o2, i0, i1, i2)
+#endif /* SPLCOL__SSE2 */
+
+SPLCOL_DEF void
+splcol_rgb_to_hsv_soa(float *h, float *s, float *v, const float *r,
+                      const float *g, const float *b, size_t n)
+{
+	size_t i = 0;
+
+	SPLCOL__SOA_SSE2(splcol__rgb_to_hsv_sse2, h, s, v, r, g, b);
+	for (; i < n; i++)
+		splcol_rgb_to_hsv(r[i], g[i], b[i], h + i, s + i, v + i);
+}
+
+SPLCOL_DEF void
+splcol_hsv_to_rgb_soa(float *r, float *g, float *b, const float *h,
+                      const float *s, const float *v, size_t n)
+{
+	size_t i = 0;
+
+	SPLCOL__SOA_SSE2(splcol__hsv_to_rgb_sse2, r, g, b, h, s, v);
+	for (; i < n; i++)
+		splcol_hsv_to_rgb(h[i], s[i], v[i], r + i, g + i, b + i);
+}
+
+SPLCOL_DEF void
+splcol_rgb_to_hsl_soa(float *h, float *s, float *l, const float *r,
+                      const float *g, const float *b, size_t n)
+{
+	size_t i = 0;
+
+	SPLCOL__SOA_SSE2(splcol__rgb_to_hsl_sse2, h, s, l, r, g, b);
+	for (; i < n; i++)
+		splcol_rgb_to_hsl(r[i], g[i], b[i], h + i, s + i, l + i);
+}
+
+SPLCOL_DEF void
+splcol_hsl_to_rgb_soa(float *r, float *g, float *b, const float *h,
+                      const float *s, const float *l, size_t n)
+{
+	size_t i = 0;
+
+	SPLCOL__SOA_SSE2(splcol__hsl_to_rgb_sse2, r, g, b, h, s, l);
+	for (; i < n; i++)
+		splcol_hsl_to_rgb(h[i], s[i], l[i], r + i, g + i, b + i);
+}
+
+SPLCOL_DEF void
+splcol_rgb_to_oklab_soa(float *l, float *a, float *bb, const float *r,
+                        const float *g, const float *b, size_t n)
+{
+	size_t i = 0;
+
+	SPLCOL__SOA_SSE2(splcol__rgb_to_oklab_sse2, l, a, bb, r, g, b);
+	for (; i < n; i++)
+		splcol_rgb_to_oklab(r[i], g[i], b[i], l + i, a + i, bb + i);
+}
+
+SPLCOL_DEF void
+splcol_oklab_to_rgb_soa(float *r, float *g, float *b, const float *l,
+                        const float *a, const float *bb, size_t n)
+{
+	size_t i = 0;
+
+	SPLCOL__SOA_SSE2(splcol__oklab_to_rgb_sse2, r, g, b, l, a, bb);
+	for (; i < n; i++)
+		splcol_oklab_to_rgb(l[i], a[i], bb[i], r + i, g + i, b + i);
+}
+
+#undef SPLCOL__SOA_SSE2
+
+/* = PALETTE = */
+
+/* Index of the lookup table cell of the 0xRRGGBBAA color `p` */
+#define SPLCOL__LUT_KEY(p)                                 \
+	((((p) >> 17) & 0x7C00) | (((p) >> 14) & 0x03E0) | \
+	 (((p) >> 11) & 0x001F))
+
+/* A non-empty cell of the quantization histogram */
+typedef struct {
+	uint32_t key;    /* 'SPLCOL__LUT_KEY()' of the cell */
+	uint32_t sort;   /* Channel currently sorted by */
+	uint64_t count;  /* Number of pixels in the cell */
+	uint64_t sum[3]; /* Sum of the red, green and blue of those pixels */
+} splcol__bin;
+
+static uint32_t
+splcol__dist2(uint32_t a, uint32_t b)
+{
+	int dr = (int)(a >> 24) - (int)(b >> 24);
+	int dg = (int)((a >> 16) & 0xFF) - (int)((b >> 16) & 0xFF);
+	int db = (int)((a >> 8) & 0xFF) - (int)((b >> 8) & 0xFF);
+
+	return (uint32_t)(dr * dr + dg * dg + db * db);
+}
+
+/* Opaque color with the rounded averages of the channel sums `sum` */
+static uint32_t
+splcol__avg_color(const uint64_t sum[3], uint64_t count)
+{
+	uint32_t c = 0xFF;
+
+	for (int k = 0; k < 3; k++)
+		c |= (uint32_t)((sum[k] + count / 2) / count) << (24 - 8 * k);
+	return c;
+}
+
+static void
+splcol__palette_fill_lut(splcol_palette *pal)
+{
+	for (uint32_t key = 0; key < 32768; key++) {
+		/* Center of the cell */
+		uint32_t c = ((key >> 10) << 27) | (((key >> 5) & 0x1F) << 19) |
+		             ((key & 0x1F) << 11) | 0x04040400;
+
+		pal->lut[key] = (uint8_t)splcol_palette_nearest(pal, c);
+	}
+}
+
+/* Channel `k` (0 for red to 2 for blue) of the lookup table cell `key` */
+static uint32_t
+splcol__key_ch(uint32_t key, int k)
+{
+	return (key >> (10 - 5 * k)) & 0x1F;
+}
+
+/* Returns the range of the widest channel of the cells `[start, end)` and
+ * fills `*ch` with the channel */
+static uint32_t
+splcol__widest_ch(const splcol__bin *bins, int start, int end, int *ch)
+{
+	uint32_t lo[3] = { 31, 31, 31 }, hi[3] = { 0, 0, 0 }, range = 0;
+
+	for (int i = start; i < end; i++) {
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = splcol__key_ch(bins[i].key, k);
+
+			lo[k] = v < lo[k] ? v : lo[k];
+			hi[k] = v > hi[k] ? v : hi[k];
+		}
+	}
+
+	*ch = 0;
+	for (int k = 0; k < 3; k++) {
+		if (hi[k] > lo[k] && hi[k] - lo[k] > range) {
+			range = hi[k] - lo[k];
+			*ch   = k;
+		}
+	}
+
+	return range;
+}
+
+static int
+splcol__bin_cmp(const void *a, const void *b)
+{
+	uint32_t x = ((const splcol__bin *)a)->sort;
+	uint32_t y = ((const splcol__bin *)b)->sort;
+
+	return (x > y) - (x < y);
+}
+
+/* Counts `px` into a histogram and moves its non-empty cells to the front.
+ * Returns the histogram (to be free'ed) and fills `*bins_c`, or NULL on
+ * allocation failure. */
+static splcol__bin *
+splcol__histogram(const uint32_t *px, size_t n, int *bins_c)
+{
+	splcol__bin *bins = (splcol__bin *)calloc(32768, sizeof(*bins));
+	int          c    = 0;
+
+	if (!bins)
+		return NULL;
+
+	for (size_t i = 0; i < n; i++) {
+		splcol__bin *bin = bins + SPLCOL__LUT_KEY(px[i]);
+
+		bin->count++;
+		bin->sum[0] += px[i] >> 24;
+		bin->sum[1] += (px[i] >> 16) & 0xFF;
+		bin->sum[2] += (px[i] >> 8) & 0xFF;
+	}
+
+	for (uint32_t key = 0; key < 32768; key++) {
+		if (!bins[key].count)
+			continue;
+		bins[c]     = bins[key];
+		bins[c].key = key;
+		c++;
+	}
+
+	*bins_c = c;
+	return bins;
+}
+
+/* Splits the histogram into at most `colors_c` boxes with median cut, storing
+ * the average color of each box into `pal`. */
+static void
+splcol__median_cut(splcol_palette *pal, splcol__bin *bins, int bins_c,
+                   int colors_c)
+{
+	int box_start[256], box_end[256], boxes_c = 1;
+
+	box_start[0] = 0;
+	box_end[0]   = bins_c;
+
+	while (boxes_c < colors_c) {
+		int      best = -1, best_ch = 0;
+		uint64_t best_score = 0;
+
+		/* Split the box with the most pixels times the range of its
+		 * widest channel, so neither a huge flat area nor a few
+		 * outliers get all the colors */
+		for (int b = 0; b < boxes_c; b++) {
+			int      start = box_start[b], end = box_end[b], ch;
+			uint32_t range;
+			uint64_t count = 0;
+
+			range = splcol__widest_ch(bins, start, end, &ch);
+			for (int i = start; i < end; i++)
+				count += bins[i].count;
+			if (range && count * range > best_score) {
+				best_score = count * range;
+				best       = b;
+				best_ch    = ch;
+			}
+		}
+		if (best < 0)
+			break;
+
+		int      start = box_start[best], end = box_end[best], mid;
+		uint64_t total = 0, acc = 0;
+
+		for (int i = start; i < end; i++) {
+			bins[i].sort = splcol__key_ch(bins[i].key, best_ch);
+			total += bins[i].count;
+		}
+		qsort(bins + start, end - start, sizeof(*bins),
+		      splcol__bin_cmp);
+
+		/* Cut at the median pixel, keeping both halves non-empty */
+		for (mid = start + 1; mid < end - 1; mid++) {
+			acc += bins[mid - 1].count;
+			if (2 * acc >= total)
+				break;
+		}
+
+		box_end[best]      = mid;
+		box_start[boxes_c] = mid;
+		box_end[boxes_c]   = end;
+		boxes_c++;
+	}
+
+	for (int b = 0; b < boxes_c; b++) {
+		uint64_t sum[3] = { 0, 0, 0 }, count = 0;
+
+		for (int i = box_start[b]; i < box_end[b]; i++) {
+			for (int k = 0; k < 3; k++)
+				sum[k] += bins[i].sum[k];
+			count += bins[i].count;
+		}
+		pal->colors[b] = splcol__avg_color(sum, count);
+	}
+	pal->colors_c = boxes_c;
+}
+
+/* Lloyd's k-means over the histogram cells, each cell standing for all of its
+ * pixels at their average color */
+static void
+splcol__kmeans(splcol_palette *pal, const splcol__bin *bins, int bins_c,
+               int iters)
+{
+	uint64_t sum[256][3], count[256];
+
+	for (int it = 0; it < iters; it++) {
+		int moved = 0;
+
+		memset(sum, 0, sizeof(sum));
+		memset(count, 0, sizeof(count));
+
+		for (int i = 0; i < bins_c; i++) {
+			int k = splcol_palette_nearest(
+				pal, splcol__avg_color(bins[i].sum,
+			                               bins[i].count));
+
+			sum[k][0] += bins[i].sum[0];
+			sum[k][1] += bins[i].sum[1];
+			sum[k][2] += bins[i].sum[2];
+			count[k] += bins[i].count;
+		}
+
+		/* Colors nothing got assigned to stay where they are */
+		for (int k = 0; k < pal->colors_c; k++) {
+			uint32_t c;
+
+			if (!count[k])
+				continue;
+			c = splcol__avg_color(sum[k], count[k]);
+			moved |= c != pal->colors[k];
+			pal->colors[k] = c;
+		}
+		if (!moved)
+			break;
+	}
+}
+
+SPLCOL_DEF int
+splcol_palette_init(splcol_palette *pal, const uint32_t *colors, int colors_c)
+{
+	pal->colors_c = 0;
+	pal->lut      = NULL;
+
+	if (colors_c < 1 || colors_c > 256)
+		return -1;
+	if (!(pal->lut = (uint8_t *)malloc(32768)))
+		return -1;
+
+	memmove(pal->colors, colors, colors_c * sizeof(*colors));
+	pal->colors_c = colors_c;
+	splcol__palette_fill_lut(pal);
+
+	return 0;
+}
+
+SPLCOL_DEF int
+splcol_palette_quantize(splcol_palette *pal, const uint32_t *px, size_t n,
+                        int colors_c, int kmeans_iters)
+{
+	splcol__bin *bins;
+	int          bins_c;
+
+	pal->colors_c = 0;
+	pal->lut      = NULL;
+
+	if (colors_c < 1 || colors_c > 256 || n == 0)
+		return -1;
+	if (!(bins = splcol__histogram(px, n, &bins_c)))
+		return -1;
+
+	splcol__median_cut(pal, bins, bins_c, colors_c);
+	splcol__kmeans(pal, bins, bins_c, kmeans_iters);
+	free(bins);
+
+	return splcol_palette_init(pal, pal->colors, pal->colors_c);
+}
+
+SPLCOL_DEF void
+splcol_palette_free(splcol_palette *pal)
+{
+	free(pal->lut);
+	pal->lut      = NULL;
+	pal->colors_c = 0;
+}
+
+SPLCOL_DEF int
+splcol_palette_lookup(const splcol_palette *pal, uint32_t color)
+{
+	return pal->lut[SPLCOL__LUT_KEY(color)];
+}
+
+SPLCOL_DEF int
+splcol_palette_nearest(const splcol_palette *pal, uint32_t color)
+{
+	uint32_t best_d = UINT32_MAX;
+	int      best   = 0;
+
+	int r = (int)(color >> 24);
+
+	for (int i = 0; i < pal->colors_c; i++) {
+		int      dr = (int)(pal->colors[i] >> 24) - r;
+		uint32_t d;
+
+		/* Most colors are already too far on red alone */
+		if ((uint32_t)(dr * dr) >= best_d)
+			continue;
+		d = splcol__dist2(pal->colors[i], color);
+		if (d < best_d) {
+			best_d = d;
+			best   = i;
+		}
+	}
+
+	return best;
+}
+
+SPLCOL_DEF void
+splcol_palette_map(const splcol_palette *pal, uint8_t *dst,
+                   const uint32_t *src, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		dst[i] = pal->lut[SPLCOL__LUT_KEY(src[i])];
+}
+
+/* = HEX STRINGS = */
+
+/* Every byte of a uint64 set to `b` */
+#define SPLCOL__BYTES(b) (0x0101010101010101ull * (b))
+
+/* Parses the 8 hex digits packed into `x`, first digit in the lowest byte.
+ * Returns -1 if any byte is not a hex digit. */
+static int
+splcol__hex_parse8(uint64_t x, uint32_t *color)
+{
+	const uint64_t high  = SPLCOL__BYTES(0x80);
+	uint64_t       lower = x | SPLCOL__BYTES(0x20), digit, alpha, nib, v;
+
+	/* Non-ASCII bytes would break the range checks below */
+	if (x & high)
+		return -1;
+
+	/* '(x | 0x80) - lo' keeps the high bit of a byte iff 'x >= lo' and
+	 * '(hi | 0x80) - x' iff 'x <= hi', without borrowing across bytes */
+	digit = ((x | high) - SPLCOL__BYTES(0x30)) &
+	        ((SPLCOL__BYTES(0x39) | high) - x);
+	alpha = ((lower | high) - SPLCOL__BYTES(0x61)) &
+	        ((SPLCOL__BYTES(0x66) | high) - lower);
+	if (((digit | alpha) & high) != high)
+		return -1;
+
+	/* 'a' to 'f' have 1 to 6 in their low nibble */
+	nib = (x & SPLCOL__BYTES(0x0F)) + ((alpha & high) >> 7) * 9;
+
+	/* Join every 2 digits into the low byte of their 16 bit lane */
+	v = ((nib << 4) | (nib >> 8)) & 0x00FF00FF00FF00FFull;
+
+	*color = (uint32_t)(((v & 0xFF) << 24) | (((v >> 16) & 0xFF) << 16) |
+	                    (((v >> 32) & 0xFF) << 8) | (v >> 48));
+	return 0;
+}
+
+SPLCOL_DEF int
+splcol_hex_parse(const char *str, int len, uint32_t *color)
+{
+	char     buf[8] = { 'f', 'f', 'f', 'f', 'f', 'f', 'f', 'f' };
+	uint64_t x      = 0;
+
+	if (len < 0)
+		len = strlen(str);
+	if (len > 0 && str[0] == '#') {
+		str++;
+		len--;
+	}
+
+	/* Everything becomes 8 digits, "ff" being the missing alpha */
+	switch (len) {
+	case 3:
+	case 4:
+		for (int i = 0; i < len; i++)
+			buf[2 * i] = buf[2 * i + 1] = str[i];
+		break;
+	case 6:
+	case 8:
+		memcpy(buf, str, len);
+		break;
+	default:
+		return -1;
+	}
+
+	/* Compiles to a single load on little-endian machines */
+	for (int k = 0; k < 8; k++)
+		x |= (uint64_t)(unsigned char)buf[k] << (8 * k);
+
+	return splcol__hex_parse8(x, color);
+}
+
+SPLCOL_DEF size_t
+splcol_hex_parse_n(uint32_t *dst, uint8_t *ok, const char *const *strs,
+                   size_t n)
+{
+	size_t bad = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		int valid = splcol_hex_parse(strs[i], -1, dst + i) == 0;
+
+		if (!valid)
+			dst[i] = 0;
+		if (ok)
+			ok[i] = (uint8_t)valid;
+		bad += !valid;
+	}
+
+	return bad;
+}
+
+SPLCOL_DEF void
+splcol_hex_format(char *buf, uint32_t color, int with_alpha)
+{
+	int      digits = with_alpha ? 8 : 6;
+	uint64_t x, nib, c;
+
+	/* One channel in the low byte of every 16 bit lane, red first */
+	x = (uint64_t)(color >> 24) | ((uint64_t)((color >> 16) & 0xFF) << 16) |
+	    ((uint64_t)((color >> 8) & 0xFF) << 32) |
+	    ((uint64_t)(color & 0xFF) << 48);
+
+	/* High nibble into the first byte of the lane, low into the second */
+	nib = ((x >> 4) & SPLCOL__BYTES(0x0F)) |
+	      ((x & 0x000F000F000F000Full) << 8);
+
+	/* '0' + nib, plus the gap between '9' and 'a' for nibbles over 9 */
+	c = nib + SPLCOL__BYTES(0x30) +
+	    (((nib + SPLCOL__BYTES(0x76)) & SPLCOL__BYTES(0x80)) >> 7) * 39;
+
+	buf[0] = '#';
+	for (int k = 0; k < digits; k++)
+		buf[1 + k] = (char)(c >> (8 * k));
+	buf[1 + digits] = '\0';
+}
+
+SPLCOL_DEF void
+splcol_hex_format_n(char *buf, const uint32_t *colors, size_t n,
+                    int with_alpha)
+{
+	size_t stride = with_alpha ? 10 : 8;
+
+	for (size_t i = 0; i < n; i++)
+		splcol_hex_format(buf + i * stride, colors[i], with_alpha);
+}
+
+#undef SPLCOL__BYTES
+
+/* = GRADIENTS = */
+
+/* Channels of `c` in the gradient space `space`, alpha staying in [0, 255] */
+static void
+splcol__gradient_in(uint32_t c, splcol_gradient_space space, float out[4])
+{
+	if (space == SPLCOL_GRADIENT_SRGB) {
+		out[0] = (float)(c >> 24) * (1.0f / 255.0f);
+		out[1] = (float)((c >> 16) & 0xFF) * (1.0f / 255.0f);
+		out[2] = (float)((c >> 8) & 0xFF) * (1.0f / 255.0f);
+	} else {
+		out[0] = splcol__srgb_dec[c >> 24];
+		out[1] = splcol__srgb_dec[(c >> 16) & 0xFF];
+		out[2] = splcol__srgb_dec[(c >> 8) & 0xFF];
+		if (space == SPLCOL_GRADIENT_OKLAB)
+			splcol_rgb_to_oklab(out[0], out[1], out[2], out,
+			                    out + 1, out + 2);
+	}
+	out[3] = (float)(c & 0xFF);
+}
+
+/* Inverse of 'splcol__gradient_in()', OKLab having been converted back to
+ * linear light RGB already */
+static uint32_t
+splcol__gradient_out(float r, float g, float b, float a,
+                     splcol_gradient_space space)
+{
+	uint32_t r8, g8, b8;
+
+	if (space == SPLCOL_GRADIENT_SRGB) {
+		r8 = splcol__unit_to_u8(r);
+		g8 = splcol__unit_to_u8(g);
+		b8 = splcol__unit_to_u8(b);
+	} else {
+		r8 = splcol_linear_to_srgb(r);
+		g8 = splcol_linear_to_srgb(g);
+		b8 = splcol_linear_to_srgb(b);
+	}
+
+	return (r8 << 24) | (g8 << 16) | (b8 << 8) | (uint32_t)(a + 0.5f);
+}
+
+SPLCOL_DEF void
+splcol_gradient(uint32_t *dst, size_t n, const splcol_gradient_stop *stops,
+                int stops_c, splcol_gradient_space space)
+{
+	/* Interpolated channels of a chunk of `dst` */
+	float c0[256], c1[256], c2[256], ca[256];
+	float from[4], to[4], last = n > 1 ? (float)(n - 1) : 1.0f;
+	int   seg = 0, cur_seg = -1;
+
+	const splcol_gradient_stop *lo = stops, *hi = stops;
+
+	if (stops_c < 1) {
+		memset(dst, 0, n * sizeof(*dst));
+		return;
+	}
+
+	for (size_t start = 0; start < n; start += 256) {
+		size_t m = n - start < 256 ? n - start : 256;
+
+		for (size_t j = 0; j < m; j++) {
+			float t = (float)(start + j) / last, u = 0.0f;
+
+			while (seg + 1 < stops_c && t >= stops[seg + 1].pos)
+				seg++;
+			if (seg != cur_seg) {
+				cur_seg = seg;
+				lo      = stops + seg;
+				hi      = seg + 1 < stops_c ? lo + 1 : lo;
+				splcol__gradient_in(lo->color, space, from);
+				splcol__gradient_in(hi->color, space, to);
+			}
+
+			/* Past the last stop or before the first one 'from' is
+			 * the color, otherwise 't' is strictly between the
+			 * positions of 'lo' and 'hi' */
+			if (hi != lo && t > lo->pos)
+				u = (t - lo->pos) / (hi->pos - lo->pos);
+
+			c0[j] = from[0] + (to[0] - from[0]) * u;
+			c1[j] = from[1] + (to[1] - from[1]) * u;
+			c2[j] = from[2] + (to[2] - from[2]) * u;
+			ca[j] = from[3] + (to[3] - from[3]) * u;
+		}
+
+		if (space == SPLCOL_GRADIENT_OKLAB)
+			splcol_oklab_to_rgb_soa(c0, c1, c2, c0, c1, c2, m);
+
+		for (size_t j = 0; j < m; j++)
+			dst[start + j] = splcol__gradient_out(
+				c0[j], c1[j], c2[j], ca[j], space);
+	}
+}
+
+/* = TERMINAL = */
+
+/* xterm's default 16 colors */
+static const uint32_t splcol__ansi16[16] = {
+	0x000000FF, 0xCD0000FF, 0x00CD00FF, 0xCDCD00FF, 0x0000EEFF, 0xCD00CDFF,
+	0x00CDCDFF, 0xE5E5E5FF, 0x7F7F7FFF, 0xFF0000FF, 0x00FF00FF, 0xFFFF00FF,
+	0x5C5CFFFF, 0xFF00FFFF, 0x00FFFFFF, 0xFFFFFFFF,
+};
+
+/* Index of the nearest of the 6 levels (0, 95, 135, ..., 255) of the 256
+ * color cube */
+static uint32_t
+splcol__cube_level(uint32_t v)
+{
+	return v < 48 ? 0 : v < 115 ? 1 : (v - 35) / 40;
+}
+
+/* Index of the nearest of the 256 colors, ignoring the first 16 whose actual
+ * colors depend on the terminal */
+static uint32_t
+splcol__ansi256(uint32_t color)
+{
+	static const uint32_t level[6] = { 0, 95, 135, 175, 215, 255 };
+
+	uint32_t r = color >> 24, g = (color >> 16) & 0xFF;
+	uint32_t b = (color >> 8) & 0xFF, avg = (r + g + b) / 3;
+	uint32_t cr = splcol__cube_level(r), cg = splcol__cube_level(g);
+	uint32_t cb = splcol__cube_level(b), gray, cube_c, gray_c;
+
+	/* Gray ramp of 24 colors from 8 to 238 */
+	gray   = avg < 3 ? 0 : avg > 238 ? 23 : (avg - 3) / 10;
+	cube_c = (level[cr] << 24) | (level[cg] << 16) | (level[cb] << 8);
+	gray_c = (8 + 10 * gray) * 0x01010100;
+
+	if (splcol__dist2(gray_c, color) < splcol__dist2(cube_c, color))
+		return 232 + gray;
+	return 16 + 36 * cr + 6 * cg + cb;
+}
+
+/* Writes the buffer out without flushing the stream */
+static void
+splcol__term_drain(splcol_term *t)
+{
+	if (t->buf_len &&
+	    fwrite(t->buf, 1, t->buf_len, t->stream) != t->buf_len)
+		t->err = 1;
+	t->buf_len = 0;
+}
+
+static char *
+splcol__put_u8(char *p, uint32_t v)
+{
+	if (v >= 100)
+		*p++ = (char)('0' + v / 100);
+	if (v >= 10)
+		*p++ = (char)('0' + v / 10 % 10);
+	*p++ = (char)('0' + v % 10);
+	return p;
+}
+
+static void
+splcol__term_color(splcol_term *t, uint32_t color, int is_bg)
+{
+	uint32_t *cur = is_bg ? &t->bg : &t->fg, key, idx = 0;
+	char     *p;
+
+	if (t->mode == SPLCOL_TERM_NONE)
+		return;
+
+	/* What would be emitted, so colors reduced to the same one are skipped
+	 * too */
+	if (!(color & 0xFF))
+		key = 0;
+	else if (t->mode == SPLCOL_TERM_TRUECOLOR)
+		key = color | 0xFF;
+	else if (t->mode == SPLCOL_TERM_256)
+		key = ((idx = splcol__ansi256(color)) << 8) | 0xFF;
+	else
+		key = ((idx = splcol_palette_lookup(&t->pal16, color)) << 8) |
+		      0xFF;
+	if (key == *cur)
+		return;
+	*cur = key;
+
+	/* Longest escape is "\x1b[48;2;255;255;255m" */
+	if (t->buf_cap - t->buf_len < 20)
+		splcol__term_drain(t);
+	p    = t->buf + t->buf_len;
+	*p++ = '\x1b';
+	*p++ = '[';
+
+	if (!key) {
+		*p++ = is_bg ? '4' : '3';
+		*p++ = '9';
+	} else if (t->mode == SPLCOL_TERM_TRUECOLOR) {
+		memcpy(p, is_bg ? "48;2;" : "38;2;", 5);
+		p    = splcol__put_u8(p + 5, color >> 24);
+		*p++ = ';';
+		p    = splcol__put_u8(p, (color >> 16) & 0xFF);
+		*p++ = ';';
+		p    = splcol__put_u8(p, (color >> 8) & 0xFF);
+	} else if (t->mode == SPLCOL_TERM_256) {
+		memcpy(p, is_bg ? "48;5;" : "38;5;", 5);
+		p = splcol__put_u8(p + 5, idx);
+	} else {
+		/* 30-37 and 90-97, 10 more for backgrounds */
+		p = splcol__put_u8(p, (idx < 8 ? 30 + idx : 82 + idx) +
+		                              (is_bg ? 10 : 0));
+	}
+
+	*p++       = 'm';
+	t->buf_len = p - t->buf;
+}
+
+SPLCOL_DEF splcol_term_mode
+splcol_term_detect(FILE *stream)
+{
+	const char *no_color = getenv("NO_COLOR");
+	const char *term = getenv("TERM"), *colorterm = getenv("COLORTERM");
+
+	if (no_color && no_color[0])
+		return SPLCOL_TERM_NONE;
+#if defined(__unix__) || defined(__APPLE__)
+	/* Not 'fileno()', which strict C99 doesn't declare. Other streams are
+	 * assumed to be files. */
+	if (!isatty(stream == stdout ? 1 : stream == stderr ? 2 : -1))
+		return SPLCOL_TERM_NONE;
+#else
+	(void)stream;
+#endif
+
+	if (colorterm && (!strcmp(colorterm, "truecolor") ||
+	                  !strcmp(colorterm, "24bit")))
+		return SPLCOL_TERM_TRUECOLOR;
+	if (!term || !strcmp(term, "dumb"))
+		return SPLCOL_TERM_NONE;
+	if (strstr(term, "256color"))
+		return SPLCOL_TERM_256;
+	return SPLCOL_TERM_16;
+}
+
+SPLCOL_DEF int
+splcol_term_init(splcol_term *t, FILE *stream, splcol_term_mode mode,
+                 size_t buf_cap)
+{
+	memset(t, 0, sizeof(*t));
+	t->stream  = stream;
+	t->mode    = mode;
+	t->buf_cap = buf_cap ? buf_cap : 65536;
+
+	/* Room for at least a few escapes */
+	if (t->buf_cap < 64)
+		t->buf_cap = 64;
+	if (!(t->buf = (char *)malloc(t->buf_cap)))
+		return -1;
+
+	if (mode == SPLCOL_TERM_16 &&
+	    splcol_palette_init(&t->pal16, splcol__ansi16, 16)) {
+		free(t->buf);
+		t->buf = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+SPLCOL_DEF int
+splcol_term_free(splcol_term *t)
+{
+	int ret = splcol_term_flush(t);
+
+	free(t->buf);
+	t->buf = NULL;
+	splcol_palette_free(&t->pal16);
+
+	return ret;
+}
+
+SPLCOL_DEF void
+splcol_term_fg(splcol_term *t, uint32_t color)
+{
+	splcol__term_color(t, color, 0);
+}
+
+SPLCOL_DEF void
+splcol_term_bg(splcol_term *t, uint32_t color)
+{
+	splcol__term_color(t, color, 1);
+}
+
+SPLCOL_DEF void
+splcol_term_reset(splcol_term *t)
+{
+	if (!t->fg && !t->bg)
+		return;
+	splcol_term_write(t, "\x1b[0m", 4);
+	t->fg = t->bg = 0;
+}
+
+SPLCOL_DEF void
+splcol_term_write(splcol_term *t, const char *str, int len)
+{
+	if (len < 0)
+		len = strlen(str);
+
+	if (t->buf_cap - t->buf_len < (size_t)len) {
+		splcol__term_drain(t);
+
+		/* Too big for the buffer, no point in copying it */
+		if (t->buf_cap < (size_t)len) {
+			if (fwrite(str, 1, len, t->stream) != (size_t)len)
+				t->err = 1;
+			return;
+		}
+	}
+
+	memcpy(t->buf + t->buf_len, str, len);
+	t->buf_len += len;
+}
+
+SPLCOL_DEF void
+splcol_term_printf(splcol_term *t, const char *fmt, ...)
+{
+	va_list ap;
+	int     len;
+	char   *tmp;
+
+	va_start(ap, fmt);
+	len = vsnprintf(t->buf + t->buf_len, t->buf_cap - t->buf_len, fmt, ap);
+	va_end(ap);
+
+	if (len < 0) {
+		t->err = 1;
+		return;
+	}
+	/* 'vsnprintf()' also needs room for the NUL */
+	if ((size_t)len < t->buf_cap - t->buf_len) {
+		t->buf_len += len;
+		return;
+	}
+
+	/* Didn't fit: format again into an empty buffer or, if it is too
+	 * small, a temporary one */
+	splcol__term_drain(t);
+	if ((size_t)len < t->buf_cap) {
+		va_start(ap, fmt);
+		vsnprintf(t->buf, t->buf_cap, fmt, ap);
+		va_end(ap);
+		t->buf_len = len;
+		return;
+	}
+
+	if (!(tmp = (char *)malloc(len + 1))) {
+		t->err = 1;
+		return;
+	}
+	va_start(ap, fmt);
+	vsnprintf(tmp, len + 1, fmt, ap);
+	va_end(ap);
+	splcol_term_write(t, tmp, len);
+	free(tmp);
+}
+
+SPLCOL_DEF int
+splcol_term_flush(splcol_term *t)
+{
+	splcol__term_drain(t);
+	if (fflush(t->stream))
+		t->err = 1;
+
+	return t->err ? -1 : 0;
+}
+
 #endif /* SPLCOL_IMPL */
 
 /*
@@ -17,7 +17,31 @@
  |                               Version History                               |
  ===============================================================================
  *
- - v0.3 (Current)
+ - v0.5 (Current)
+     - 'spl_flag_info' lists are now allocated from the arguments instead of
+       being fixed 256 entry arrays, and the struct is passed around by
+       pointer: 'spl_flag_parse()' returns a pointer to the global
+       'spl_flag_parsed', 'spl_flag_print_gotchas()' and
+       'spl_flag_warn_ignored_args()' take a pointer.
+     - Added 'err' field with 'spl_flag_err' bits and 'spl_flag_info_free()'.
+     - Fixed a crash when a long flag expecting a value was the last argument.
+ - v0.4
+     - Added 'spl_flag_set' to hold flags outside of the global 'spl_flag'
+       table along with 'spl_flag_set_*()' variants of the flag functions.
+     - Added subcommands with 'spl_flag_cmd', 'spl_flag_cmd_find()',
+       'spl_flag_cmd_parse()' and 'spl_flag_cmd_print_help()'.
+     - 'spl_flag_set' now owns the result of its parse, making it usable from
+       multiple threads.
+     - Added 'SPL_FLAG_NO_GLOBAL' option.
+     - The help message is now rendered into a single buffer with the info of
+       every flag aligned, and is cached by 'spl_flag_set_help()'.
+     - Added bash/zsh completion script generation with
+       'spl_flag_print_completion()', 'spl_flag_set_print_completion()' and
+       'spl_flag_cmd_print_completion()'.
+     - Added a completion fast path answering from a sorted index of the long
+       flags without parsing: 'spl_flag_set_complete()',
+       '*_complete_argv()' and 'spl_flag_print_complete_hook()'.
+ - v0.3
      - Changed all identifiers from '*_f' to an explicit '*_flag'.
      - Added proper C++ support by replacing the '{ 0 }' syntax with 'memset()'.
  - v0.2
@@ -33,6 +57,13 @@
  * Just include this header file and you are done.
  *
  * See the example code below and check out the options.
+ *
+ * The 'spl_flag_*()' functions work on a 'static' global table, so every
+ * translation unit including this file gets its own copy and parsing isn't
+ * reentrant. When parsing from multiple threads (or just to avoid the table)
+ * use a 'spl_flag_set' per parse instead: the set owns its flags and its parse
+ * results so independent sets need no locking. Defining 'SPL_FLAG_NO_GLOBAL'
+ * removes the global table and the functions working on it altogether.
  */
 
 /*
@@ -65,7 +96,7 @@ main(int argc, char **argv)
 	spl_flag_float(&gpa, ' ', "gpa", "Your gpa");
 	spl_flag_str(&univ, 'u', "university", "Your university");
 
-	spl_flag_info f_info = spl_flag_parse(argc, argv);
+	spl_flag_info *f_info = spl_flag_parse(argc, argv);
 
 	/* Printing any gotchas in parsing */
 	if (spl_flag_print_gotchas(f_info, stderr))
@@ -83,11 +114,11 @@ main(int argc, char **argv)
 	spl_flag_warn_ignored_args(f_info, stderr, 1);
 
 	/* Check if the user gave us a name as an argument */
-	if (f_info.non_flag_arguments_c == 0) {
+	if (f_info->non_flag_arguments_c == 0) {
 		fprintf(stderr, "Usage: %s name\n", argv[0]);
 		exit(EXIT_FAILURE);
 	}
-	name = f_info.non_flag_arguments[0];
+	name = f_info->non_flag_arguments[0];
 
 	if (to_greet)
 		printf("Greetings!\n");
@@ -95,6 +126,7 @@ main(int argc, char **argv)
 	printf("Your name is %s aged %d studying in %s and you got %.2f gpa.\n",
 	       name, age, univ, gpa);
 
+	spl_flag_info_free(f_info);
 	return 0;
 }
 #endif
@@ -107,21 +139,21 @@ $ ./bin/flags -h
 Usage: ./bin/flags name
 
 Available options are:
-    -h, --help, (Default: Off)  Print the help message
-    -g, --greet, (Default: Off) To greet
-    -a, (Default: 20)   Your age
-    --gpa, (Default: 3.60)      Your gpa
-    -u, --university, (Default: 'Tribhuvan University') Your university
+    -h, --help, (Default: Off)                           Print the help message
+    -g, --greet, (Default: Off)                          To greet
+    -a, (Default: 20)                                    Your age
+    --gpa, (Default: 3.60)                               Your gpa
+    -u, --university, (Default: 'Tribhuvan University')  Your university
 
 $ ./bin/flags --help
 Usage: ./bin/flags name
 
 Available options are:
-    -h, --help, (Default: Off)  Print the help message
-    -g, --greet, (Default: Off) To greet
-    -a, (Default: 20)   Your age
-    --gpa, (Default: 3.60)      Your gpa
-    -u, --university, (Default: 'Tribhuvan University') Your university
+    -h, --help, (Default: Off)                           Print the help message
+    -g, --greet, (Default: Off)                          To greet
+    -a, (Default: 20)                                    Your age
+    --gpa, (Default: 3.60)                               Your gpa
+    -u, --university, (Default: 'Tribhuvan University')  Your university
 
 $ ./bin/flags Safal
 Your name is Safal aged 20 studying in Tribhuvan University and you got 3.60 gpa.
@@ -154,6 +186,9 @@ No value given on the short flag 'u'
 
 #define SPL_FLAG_MAX 256 /* Max number of flags to support */
 
+/* Define 'SPL_FLAG_NO_GLOBAL' to leave out the global 'spl_flag' table and the
+ * functions using it, keeping only the 'spl_flag_set' API. */
+
 #ifndef SPL_FLAG_FLOAT_PRECISION
 #define SPL_FLAG_FLOAT_PRECISION "2" /* Float precision on 'print_help()' */
 #endif
@@ -169,6 +204,12 @@ No value given on the short flag 'u'
 	"On" /* String representation for toggle 1 on 'print_help()' */
 #endif
 
+/* Argument the shell passes to ask for completions, see
+ * 'spl_flag_complete_argv()' */
+#ifndef SPL_FLAG_COMPLETE_ARG
+#define SPL_FLAG_COMPLETE_ARG "--spl-flag-complete"
+#endif
+
 /*
  ===============================================================================
  |                       HEADER-FILE/IMPLEMENTATION MODE                       |
@@ -204,6 +245,19 @@ typedef enum {
 	LONG_EQUAL
 } spl_flag_arg_type;
 
+/* Bits of the 'err' field of 'spl_flag_info' */
+typedef enum {
+	SPL_FLAG_OK            = 0,
+	SPL_FLAG_ERR_NO_VALUE  = 1 << 0, /* A flag expecting a value was last */
+	SPL_FLAG_ERR_UNDEFINED = 1 << 1, /* Undefined flags were passed */
+	SPL_FLAG_ERR_NO_MEM    = 1 << 2  /* The result couldn't be allocated */
+} spl_flag_err;
+
+typedef enum {
+	SPL_FLAG_SHELL_BASH,
+	SPL_FLAG_SHELL_ZSH
+} spl_flag_shell;
+
 /* = Unions = */
 typedef union {
 	int   tog_num;
@@ -221,20 +275,62 @@ typedef struct {
 	void              *data_ptr;
 } spl_flag_entry;
 
+/*
+ * Result of a parse.
+ *
+ * The lists point into a single block allocated by the parse and sized from
+ * the given arguments, so they can't overflow. The block is reused by later
+ * parses into the same struct and released with 'spl_flag_info_free()'.
+ */
 typedef struct {
-	char *non_defined_flags_long[256];
-	char  non_defined_flags_short[256];
-	char *non_flag_arguments[256];
-	int   non_defined_flags_long_c;
-	int   non_defined_flags_short_c;
-	int   non_flag_arguments_c;
-	char *non_value_flag_long;
-	char  non_value_flag_short; /* '\0' = empty */
+	char **non_defined_flags_long;
+	char  *non_defined_flags_short;
+	char **non_flag_arguments;
+	int    non_defined_flags_long_c;
+	int    non_defined_flags_short_c;
+	int    non_flag_arguments_c;
+	char  *non_value_flag_long;
+	char   non_value_flag_short; /* '\0' = empty */
+	int    err;                  /* 'spl_flag_err' bits */
+	void  *mem;                  /* Block backing the lists */
+	size_t mem_size;
 } spl_flag_info;
 
+/*
+ * A standalone collection of flags, used in place of the global 'spl_flag'
+ * table. Entries are allocated as they are registered so a set only costs as
+ * much as the flags put into it. The set also holds the result of its last
+ * parse, so separate sets can be used from separate threads.
+ *
+ * Initialize with 'spl_flag_set_init()' and release with 'spl_flag_set_free()'.
+ */
+typedef struct {
+	spl_flag_entry  *flags;
+	int              flags_c;
+	int              flags_cap;
+	spl_flag_info    info;       /* Result of the last parse */
+	char            *help;       /* Cached 'spl_flag_set_help()' */
+	size_t           help_len;
+	spl_flag_entry **long_idx;   /* Flags sorted by long hand */
+	int              long_idx_c;
+} spl_flag_set;
+
+/* Registers the flags of a subcommand into `set`. `data` is the pointer given
+ * to 'spl_flag_cmd_parse()'. */
+typedef void (*spl_flag_cmd_register)(spl_flag_set *set, void *data);
+
+typedef struct {
+	const char           *name;
+	const char           *info;
+	spl_flag_cmd_register reg;
+} spl_flag_cmd;
+
 /* = Global variables = */
+#ifndef SPL_FLAG_NO_GLOBAL
 static spl_flag_entry spl_flag[SPL_FLAG_MAX];
 static int            spl_flag_c = 0;
+static spl_flag_info  spl_flag_parsed; /* Result of 'spl_flag_parse()' */
+#endif
 
 /*
  ===============================================================================
@@ -242,6 +338,7 @@ static int            spl_flag_c = 0;
  ===============================================================================
  */
 
+#ifndef SPL_FLAG_NO_GLOBAL
 /* Creates a toggle-type flag. */
 SPL_FLAG_DEF void
 spl_flag_toggle(int *f_toggle, const char short_hand, const char *long_hand,
@@ -267,10 +364,48 @@ spl_flag_str(char **f_str, const char short_hand, const char *long_hand,
  *
  * Make sure to pass the argc and argv from the 'main' without any
  * modifications.
+ *
+ * The result is stored in the global 'spl_flag_parsed', which is also what's
+ * returned. It stays valid until the next 'spl_flag_parse()'. The lists are
+ * owned by 'spl_flag_parsed' and the block is reused by later parses; pass the
+ * result to 'spl_flag_info_free()' once done with it to release the block.
  */
-SPL_FLAG_DEF spl_flag_info
+SPL_FLAG_DEF spl_flag_info *
 spl_flag_parse(int argc, char **argv);
 
+/*
+ * Outputs the help message to the given `stream`.
+ *
+ * The whole message is rendered into a single buffer, with the info of every
+ * flag aligned on the same column, and written with a single 'fwrite()'.
+ */
+SPL_FLAG_DEF void
+spl_flag_print_help(FILE *stream);
+
+/*
+ * Outputs a completion script for `shell` completing the flags of the program
+ * named `prog` to the given `stream`.
+ *
+ * For bash, source the output (e.g. from '~/.bashrc'). For zsh, save it as
+ * '_`prog`' somewhere in '$fpath'.
+ */
+SPL_FLAG_DEF void
+spl_flag_print_completion(const char *prog, spl_flag_shell shell,
+                          FILE *stream);
+
+/*
+ * Completion fast path. If `argv[1]` is 'SPL_FLAG_COMPLETE_ARG', the flags
+ * completing the last argument are output to stdout one per line and the
+ * program exits right away without parsing anything. Otherwise nothing is
+ * done.
+ *
+ * Call it right after registering the flags and before 'spl_flag_parse()'.
+ * See 'spl_flag_print_complete_hook()' for the shell side.
+ */
+SPL_FLAG_DEF void
+spl_flag_complete_argv(int argc, char **argv);
+#endif /* SPL_FLAG_NO_GLOBAL */
+
 /*
  * Sometimes the user provides more arguments (namely 'non_flag_arguments') than
  * anticipated and are ignored.  Warn about it.
@@ -279,22 +414,180 @@ spl_flag_parse(int argc, char **argv);
  * ignored.
  */
 SPL_FLAG_DEF void
-spl_flag_warn_ignored_args(spl_flag_info f_info, FILE *stream, int index);
-
-/* Outputs the help message to the given `stream`. */
-SPL_FLAG_DEF void
-spl_flag_print_help(FILE *stream);
+spl_flag_warn_ignored_args(const spl_flag_info *f_info, FILE *stream,
+                           int index);
 
 /*
  * Outputs any gotchas in the parsing to the given `stream` by reading the
- * 'non_defined_flags_long_c', 'non_defined_flags_short_c',
- * 'non_flag_arguments_c', 'non_value_flag_long', 'non_value_flag_short' fields
- * of the 'spl_flag_info' struct.
+ * 'err', 'non_defined_flags_long', 'non_defined_flags_short',
+ * 'non_value_flag_long', 'non_value_flag_short' fields of the 'spl_flag_info'
+ * struct.
  *
  * Returns 1 if any gotchas was found.
  */
 SPL_FLAG_DEF int
-spl_flag_print_gotchas(spl_flag_info f_info, FILE *stream);
+spl_flag_print_gotchas(const spl_flag_info *f_info, FILE *stream);
+
+/* Frees the block backing the lists of `f_info` and clears it. Meant for the
+ * result of 'spl_flag_parse()'; the result of 'spl_flag_set_parse()' is owned
+ * by the set and freed by 'spl_flag_set_free()'. */
+SPL_FLAG_DEF void
+spl_flag_info_free(spl_flag_info *f_info);
+
+/* = Flag sets = */
+
+/* Initializes an empty flag set. */
+SPL_FLAG_DEF void
+spl_flag_set_init(spl_flag_set *set);
+
+/* Frees the entries of the flag set. The set can be reused after another
+ * 'spl_flag_set_init()'. */
+SPL_FLAG_DEF void
+spl_flag_set_free(spl_flag_set *set);
+
+/*
+ * Same as 'spl_flag_toggle()', 'spl_flag_int()', 'spl_flag_float()' and
+ * 'spl_flag_str()' but the flag is added to `set` instead of the global table.
+ *
+ * Returns 0 on success OR -1 if the set couldn't grow.
+ */
+SPL_FLAG_DEF int
+spl_flag_set_toggle(spl_flag_set *set, int *f_toggle, const char short_hand,
+                    const char *long_hand, const char *info);
+
+SPL_FLAG_DEF int
+spl_flag_set_int(spl_flag_set *set, int *f_int, const char short_hand,
+                 const char *long_hand, const char *info);
+
+SPL_FLAG_DEF int
+spl_flag_set_float(spl_flag_set *set, float *f_float, const char short_hand,
+                   const char *long_hand, const char *info);
+
+SPL_FLAG_DEF int
+spl_flag_set_str(spl_flag_set *set, char **f_str, const char short_hand,
+                 const char *long_hand, const char *info);
+
+/*
+ * Same as 'spl_flag_parse()' but only the flags in `set` are considered.
+ *
+ * The result is stored in the 'info' field of `set`, which is also what's
+ * returned. It stays valid until the next parse on the same set.
+ */
+SPL_FLAG_DEF const spl_flag_info *
+spl_flag_set_parse(spl_flag_set *set, int argc, char **argv);
+
+/*
+ * Returns the help message of the flags in `set` as printed by
+ * 'spl_flag_set_print_help()', e.g. to 'write()' it directly to a file
+ * descriptor. `*len` is filled with its length if non-NULL.
+ *
+ * The message is rendered on the first call and cached in `set` until a flag
+ * is added to it, so the returned string must not be free'ed.
+ *
+ * Returns NULL if the message couldn't be allocated.
+ */
+SPL_FLAG_DEF const char *
+spl_flag_set_help(spl_flag_set *set, size_t *len);
+
+/* Same as 'spl_flag_print_help()' but for the flags in `set`. */
+SPL_FLAG_DEF void
+spl_flag_set_print_help(spl_flag_set *set, FILE *stream);
+
+/* Same as 'spl_flag_print_completion()' but for the flags in `set`. */
+SPL_FLAG_DEF void
+spl_flag_set_print_completion(spl_flag_set *set, const char *prog,
+                              spl_flag_shell shell, FILE *stream);
+
+/*
+ * Outputs the flags of `set` completing `word` (e.g. "--ver") to the given
+ * `stream`, one per line. Long flags are looked up by binary search in an
+ * index sorted by long hand, built on the first call and cached in `set` until
+ * a flag is added to it.
+ *
+ * Returns the number of candidates OR -1 if the index couldn't be allocated.
+ */
+SPL_FLAG_DEF int
+spl_flag_set_complete(spl_flag_set *set, const char *word, FILE *stream);
+
+/* Same as 'spl_flag_complete_argv()' but for the flags in `set`. */
+SPL_FLAG_DEF void
+spl_flag_set_complete_argv(spl_flag_set *set, int argc, char **argv);
+
+/* = Subcommands = */
+
+/* Returns the subcommand in `cmds` (having `cmds_c` entries) named `name` OR
+ * NULL if there is none. */
+SPL_FLAG_DEF const spl_flag_cmd *
+spl_flag_cmd_find(const spl_flag_cmd *cmds, int cmds_c, const char *name);
+
+/*
+ * Selects the subcommand named by `argv[1]`, registers only its flags into
+ * `set` by calling its 'reg' with `data` and parses the rest of the arguments
+ * with 'spl_flag_set_parse()', leaving the result in 'set->info'. The
+ * subcommand name takes the place of the program name (`argv[0]`) for that
+ * parse.
+ *
+ * Flags of the other subcommands are never registered, so the work done is
+ * proportional to the selected subcommand only.
+ *
+ * Returns the selected subcommand OR NULL if `argv[1]` is missing or isn't a
+ * known subcommand, in which case `set` is left untouched.
+ *
+ * Example:
+ *
+ *         static void
+ *         reg_clone(spl_flag_set *set, void *data)
+ *         {
+ *                 struct clone_opts *o = data;
+ *                 spl_flag_set_int(set, &o->depth, 'd', "depth", "Depth");
+ *         }
+ *
+ *         static const spl_flag_cmd cmds[] = {
+ *                 { "clone", "Clone a repository", reg_clone },
+ *                 ...
+ *         };
+ *
+ *         spl_flag_set set;
+ *         spl_flag_set_init(&set);
+ *         cmd = spl_flag_cmd_parse(cmds, 2, &set, &opts, argc, argv);
+ */
+SPL_FLAG_DEF const spl_flag_cmd *
+spl_flag_cmd_parse(const spl_flag_cmd *cmds, int cmds_c, spl_flag_set *set,
+                   void *data, int argc, char **argv);
+
+/* Outputs the name and info of every subcommand to the given `stream`. */
+SPL_FLAG_DEF void
+spl_flag_cmd_print_help(const spl_flag_cmd *cmds, int cmds_c, FILE *stream);
+
+/*
+ * Same as 'spl_flag_print_completion()' but completes the subcommand names in
+ * `cmds` as the first argument and the flags of the chosen subcommand after
+ * it. Every subcommand is registered (with `data`) into a temporary set to
+ * generate the script.
+ */
+SPL_FLAG_DEF void
+spl_flag_cmd_print_completion(const spl_flag_cmd *cmds, int cmds_c,
+                              void *data, const char *prog,
+                              spl_flag_shell shell, FILE *stream);
+
+/*
+ * Same as 'spl_flag_complete_argv()' but for subcommands. When the last
+ * argument is the first one after 'SPL_FLAG_COMPLETE_ARG', the subcommand
+ * names are completed. Otherwise only the subcommand given first is
+ * registered (with `data`) and its flags are completed.
+ */
+SPL_FLAG_DEF void
+spl_flag_cmd_complete_argv(const spl_flag_cmd *cmds, int cmds_c, void *data,
+                           int argc, char **argv);
+
+/*
+ * Outputs a `shell` script hooking the completion of `prog` up to its
+ * 'SPL_FLAG_COMPLETE_ARG' fast path. Unlike 'spl_flag_print_completion()' the
+ * script doesn't list the flags, so it never goes stale.
+ */
+SPL_FLAG_DEF void
+spl_flag_print_complete_hook(const char *prog, spl_flag_shell shell,
+                             FILE *stream);
 
 /*
  ===============================================================================
@@ -302,65 +595,119 @@ spl_flag_print_gotchas(spl_flag_info f_info, FILE *stream);
  ===============================================================================
  */
 
-#define SPL_FLAG_ADD_MACRO                                         \
-	spl_flag[spl_flag_c].short_hand = short_hand;              \
-	if (long_hand != NULL)                                     \
-		strcpy(spl_flag[spl_flag_c].long_hand, long_hand); \
-	else                                                       \
-		spl_flag[spl_flag_c].long_hand[0] = '\0';          \
-	strcpy(spl_flag[spl_flag_c].info, info);                   \
-	++spl_flag_c;
+static void
+spl_flag__fill(spl_flag_entry *entry, spl_flag_type type, void *data_ptr,
+               const char short_hand, const char *long_hand, const char *info)
+{
+	entry->type       = type;
+	entry->data_ptr   = data_ptr;
+	entry->short_hand = short_hand;
+	if (long_hand != NULL)
+		strcpy(entry->long_hand, long_hand);
+	else
+		entry->long_hand[0] = '\0';
+	strcpy(entry->info, info);
+
+	switch (type) {
+	case SPL_FLAG_TYPE_TOGGLE:
+	case SPL_FLAG_TYPE_INT:
+		entry->def_value.tog_num = *(int *)data_ptr;
+		break;
+	case SPL_FLAG_TYPE_FLOAT:
+		entry->def_value.float_num = *(float *)data_ptr;
+		break;
+	case SPL_FLAG_TYPE_STR:
+		if (*(char **)data_ptr != NULL)
+			strcpy(entry->def_value.str, *(char **)data_ptr);
+		break;
+	}
+}
 
+#ifndef SPL_FLAG_NO_GLOBAL
 SPL_FLAG_DEF void
 spl_flag_toggle(int *f_toggle, const char short_hand, const char *long_hand,
                 const char *info)
 {
-	spl_flag[spl_flag_c].type              = SPL_FLAG_TYPE_TOGGLE;
-	spl_flag[spl_flag_c].data_ptr          = (void *)f_toggle;
-	spl_flag[spl_flag_c].def_value.tog_num = *f_toggle;
-	SPL_FLAG_ADD_MACRO
+	spl_flag__fill(&spl_flag[spl_flag_c++], SPL_FLAG_TYPE_TOGGLE,
+	               (void *)f_toggle, short_hand, long_hand, info);
 }
 
 SPL_FLAG_DEF void
 spl_flag_int(int *f_int, const char short_hand, const char *long_hand,
              const char *info)
 {
-	spl_flag[spl_flag_c].type              = SPL_FLAG_TYPE_INT;
-	spl_flag[spl_flag_c].data_ptr          = (void *)f_int;
-	spl_flag[spl_flag_c].def_value.tog_num = *f_int;
-	SPL_FLAG_ADD_MACRO
+	spl_flag__fill(&spl_flag[spl_flag_c++], SPL_FLAG_TYPE_INT,
+	               (void *)f_int, short_hand, long_hand, info);
 }
 
 SPL_FLAG_DEF void
 spl_flag_float(float *f_float, const char short_hand, const char *long_hand,
                const char *info)
 {
-	spl_flag[spl_flag_c].type                = SPL_FLAG_TYPE_FLOAT;
-	spl_flag[spl_flag_c].data_ptr            = (void *)f_float;
-	spl_flag[spl_flag_c].def_value.float_num = *f_float;
-	SPL_FLAG_ADD_MACRO
+	spl_flag__fill(&spl_flag[spl_flag_c++], SPL_FLAG_TYPE_FLOAT,
+	               (void *)f_float, short_hand, long_hand, info);
 }
 
 SPL_FLAG_DEF void
 spl_flag_str(char **f_str, const char short_hand, const char *long_hand,
              const char *info)
 {
-	spl_flag[spl_flag_c].type     = SPL_FLAG_TYPE_STR;
-	spl_flag[spl_flag_c].data_ptr = (void **)f_str;
-	if (*f_str != NULL)
-		strcpy(spl_flag[spl_flag_c].def_value.str, *f_str);
-	SPL_FLAG_ADD_MACRO
+	spl_flag__fill(&spl_flag[spl_flag_c++], SPL_FLAG_TYPE_STR,
+	               (void *)f_str, short_hand, long_hand, info);
 }
+#endif /* SPL_FLAG_NO_GLOBAL */
 
-SPL_FLAG_DEF spl_flag_info
-spl_flag_parse(int argc, char **argv)
+/*
+ * Resets `*f_info` and makes its lists big enough for any parse of `argv`,
+ * reusing its previous block if possible.
+ *
+ * Returns 0 on success OR -1 if the lists couldn't be allocated.
+ */
+static int
+spl_flag__info_reset(spl_flag_info *f_info, int argc, char **argv)
+{
+	void  *mem      = f_info->mem;
+	size_t mem_size = f_info->mem_size;
+	size_t args_c   = argc > 0 ? argc : 0;
+	size_t shorts_c = 0;
+	size_t size;
+
+	/* Every undefined short flag is a distinct character of some argument */
+	for (int i = 1; i < argc && shorts_c < 256; i++) {
+		if (argv[i][0] == '-')
+			shorts_c += strlen(argv[i]);
+	}
+	if (shorts_c > 256)
+		shorts_c = 256;
+	size = 2 * args_c * sizeof(char *) + shorts_c;
+
+	if (size > mem_size) {
+		free(mem);
+		mem      = malloc(size);
+		mem_size = mem ? size : 0;
+	}
+
+	memset(f_info, 0, sizeof(*f_info));
+	f_info->mem      = mem;
+	f_info->mem_size = mem_size;
+	if (!mem && size > 0)
+		return -1;
+
+	f_info->non_defined_flags_long  = (char **)mem;
+	f_info->non_flag_arguments      = (char **)mem + args_c;
+	f_info->non_defined_flags_short = (char *)((char **)mem + 2 * args_c);
+	return 0;
+}
+
+/* Parses `argv` against the `flags_c` entries of `flags` into `*f_info`,
+ * whose lists are already big enough. */
+static void
+spl_flag__parse_args(spl_flag_entry *flags, int flags_c, int argc,
+                     char **argv, spl_flag_info *f_info)
 {
 	int   is_double_dash = 0;
 	char *cur_arg;
 
-	spl_flag_info f_info;
-	memset(&f_info, 0, sizeof(f_info));
-
 	for (int i = 1; i < argc; i++) {
 		int   is_long_arg = 0;
 		char *equal_ch;
@@ -369,8 +716,8 @@ spl_flag_parse(int argc, char **argv)
 		 * a flag type argument (not starting with - OR starting with
 		 * quotation mark */
 		if (is_double_dash || argv[i][0] != '-' || argv[i][0] == '"') {
-			f_info.non_flag_arguments[f_info.non_flag_arguments_c++] =
-				argv[i];
+			f_info->non_flag_arguments
+				[f_info->non_flag_arguments_c++] = argv[i];
 			continue;
 		}
 
@@ -397,18 +744,18 @@ spl_flag_parse(int argc, char **argv)
 
 		spl_flag_arg_type a_type = NONE;
 		/* Iterate through defined flags and search for valid flag */
-		for (int j = 0; j < spl_flag_c; j++) {
+		for (int j = 0; j < flags_c; j++) {
 			/* Get the argument type */
 			if (is_long_arg) {
 				if (equal_ch &&
-				    ((strncmp(cur_arg, spl_flag[j].long_hand,
+				    ((strncmp(cur_arg, flags[j].long_hand,
 				              equal_ch - cur_arg)) == 0))
 					a_type = LONG_EQUAL;
 				else if ((strcmp(cur_arg,
-				                 spl_flag[j].long_hand)) == 0)
+				                 flags[j].long_hand)) == 0)
 					a_type = LONG_NON_EQUAL;
 			} else {
-				if (cur_arg[0] == spl_flag[j].short_hand) {
+				if (cur_arg[0] == flags[j].short_hand) {
 					if (equal_ch)
 						a_type = SHORT_EQUAL;
 					else
@@ -423,31 +770,31 @@ spl_flag_parse(int argc, char **argv)
 			switch (a_type) {
 			case LONG_EQUAL:
 			case SHORT_EQUAL:
-				switch (spl_flag[j].type) {
+				switch (flags[j].type) {
 				case SPL_FLAG_TYPE_TOGGLE:
-					*((int *)spl_flag[j].data_ptr) =
+					*((int *)flags[j].data_ptr) =
 						atoi(equal_ch + 1);
 					break;
 				case SPL_FLAG_TYPE_INT:
-					*((int *)spl_flag[j].data_ptr) =
+					*((int *)flags[j].data_ptr) =
 						atoi(equal_ch + 1);
 					break;
 				case SPL_FLAG_TYPE_FLOAT:
-					*((float *)spl_flag[j].data_ptr) =
+					*((float *)flags[j].data_ptr) =
 						atof(equal_ch + 1);
 					break;
 				case SPL_FLAG_TYPE_STR:
-					*((char **)spl_flag[j].data_ptr) =
+					*((char **)flags[j].data_ptr) =
 						equal_ch + 1;
 					break;
 				}
 				break;
 			case LONG_NON_EQUAL:
 			case SHORT_NON_EQUAL:
-				switch (spl_flag[j].type) {
+				switch (flags[j].type) {
 				case SPL_FLAG_TYPE_TOGGLE:
-					*((int *)spl_flag[j].data_ptr) =
-						!*((int *)spl_flag[j].data_ptr);
+					*((int *)flags[j].data_ptr) =
+						!*((int *)flags[j].data_ptr);
 					/* Check if other arguments can be
 					 * parsed after cur_arg but in the
 					 * current argv */
@@ -464,68 +811,71 @@ spl_flag_parse(int argc, char **argv)
 					break;
 				case SPL_FLAG_TYPE_INT:
 					if (i == argc - 1) {
-						if (a_type == LONG_NON_EQUAL)
-							f_info.non_value_flag_long =
+						if (a_type == LONG_NON_EQUAL) {
+							f_info->non_value_flag_long =
 								cur_arg;
-						else if (cur_arg[1] == '\0') {
-							f_info.non_value_flag_short =
+							return;
+						} else if (cur_arg[1] == '\0') {
+							f_info->non_value_flag_short =
 								*cur_arg;
-							return f_info;
+							return;
 						}
 					}
 
 					if (a_type == SHORT_NON_EQUAL &&
 					    *(cur_arg + 1) != '\0') {
-						*((int *)spl_flag[j].data_ptr) =
+						*((int *)flags[j].data_ptr) =
 							atoi(cur_arg + 1);
 						break;
 					}
 
-					*((int *)spl_flag[j].data_ptr) =
+					*((int *)flags[j].data_ptr) =
 						atoi(argv[++i]);
 					break;
 				case SPL_FLAG_TYPE_FLOAT:
 					if (i == argc - 1) {
-						if (a_type == LONG_NON_EQUAL)
-							f_info.non_value_flag_long =
+						if (a_type == LONG_NON_EQUAL) {
+							f_info->non_value_flag_long =
 								cur_arg;
-						else if (cur_arg[1] == '\0') {
-							f_info.non_value_flag_short =
+							return;
+						} else if (cur_arg[1] == '\0') {
+							f_info->non_value_flag_short =
 								*cur_arg;
-							return f_info;
+							return;
 						}
 					}
 
 					if (a_type == SHORT_NON_EQUAL &&
 					    *(cur_arg + 1) != '\0') {
-						*((float *)spl_flag[j].data_ptr) =
+						*((float *)flags[j].data_ptr) =
 							atof(cur_arg + 1);
 						break;
 					}
 
-					*((float *)spl_flag[j].data_ptr) =
+					*((float *)flags[j].data_ptr) =
 						atof(argv[++i]);
 					break;
 				case SPL_FLAG_TYPE_STR:
 					if (i == argc - 1) {
-						if (a_type == LONG_NON_EQUAL)
-							f_info.non_value_flag_long =
+						if (a_type == LONG_NON_EQUAL) {
+							f_info->non_value_flag_long =
 								cur_arg;
-						else if (cur_arg[1] == '\0') {
-							f_info.non_value_flag_short =
+							return;
+						} else if (cur_arg[1] == '\0') {
+							f_info->non_value_flag_short =
 								*cur_arg;
-							return f_info;
+							return;
 						}
 					}
 
 					if (a_type == SHORT_NON_EQUAL &&
 					    *(cur_arg + 1) != '\0') {
-						*((char **)spl_flag[j].data_ptr) =
+						*((char **)flags[j].data_ptr) =
 							cur_arg + 1;
 						break;
 					}
 
-					*((char **)spl_flag[j].data_ptr) =
+					*((char **)flags[j].data_ptr) =
 						argv[++i];
 					break;
 				}
@@ -541,8 +891,8 @@ spl_flag_parse(int argc, char **argv)
 		/* Check if the argument was an undefined flag */
 		if (a_type == NONE) {
 			if (is_long_arg)
-				f_info.non_defined_flags_long
-					[f_info.non_defined_flags_long_c++] =
+				f_info->non_defined_flags_long
+					[f_info->non_defined_flags_long_c++] =
 					cur_arg;
 			else {
 				/* First check if the undefined short flag was
@@ -550,9 +900,9 @@ spl_flag_parse(int argc, char **argv)
 
 				int was_already_passed = 0;
 				for (int i = 0;
-				     i < f_info.non_defined_flags_short_c;
+				     i < f_info->non_defined_flags_short_c;
 				     i++) {
-					if (f_info.non_defined_flags_short[i] ==
+					if (f_info->non_defined_flags_short[i] ==
 					    *cur_arg) {
 						was_already_passed = 1;
 						break;
@@ -560,8 +910,8 @@ spl_flag_parse(int argc, char **argv)
 				}
 
 				if (!was_already_passed)
-					f_info.non_defined_flags_short
-						[f_info.non_defined_flags_short_c++] =
+					f_info->non_defined_flags_short
+						[f_info->non_defined_flags_short_c++] =
 						*cur_arg;
 
 				/* Check if other arguments can be parsed after
@@ -574,98 +924,419 @@ spl_flag_parse(int argc, char **argv)
 			}
 		}
 	}
+}
+
+/* Parses `argv` against the `flags_c` entries of `flags` into `*f_info`. */
+static void
+spl_flag__parse(spl_flag_entry *flags, int flags_c, int argc, char **argv,
+                spl_flag_info *f_info)
+{
+	if (spl_flag__info_reset(f_info, argc, argv) < 0) {
+		f_info->err = SPL_FLAG_ERR_NO_MEM;
+		return;
+	}
+
+	spl_flag__parse_args(flags, flags_c, argc, argv, f_info);
 
-	return f_info;
+	if (f_info->non_value_flag_long || f_info->non_value_flag_short)
+		f_info->err |= SPL_FLAG_ERR_NO_VALUE;
+	if (f_info->non_defined_flags_long_c > 0 ||
+	    f_info->non_defined_flags_short_c > 0)
+		f_info->err |= SPL_FLAG_ERR_UNDEFINED;
 }
 
+#ifndef SPL_FLAG_NO_GLOBAL
+SPL_FLAG_DEF spl_flag_info *
+spl_flag_parse(int argc, char **argv)
+{
+	spl_flag__parse(spl_flag, spl_flag_c, argc, argv, &spl_flag_parsed);
+	return &spl_flag_parsed;
+}
+#endif /* SPL_FLAG_NO_GLOBAL */
+
 SPL_FLAG_DEF void
-spl_flag_warn_ignored_args(spl_flag_info f_info, FILE *stream, int index)
+spl_flag_warn_ignored_args(const spl_flag_info *f_info, FILE *stream,
+                           int index)
 {
-	if (index >= f_info.non_flag_arguments_c) {
+	if (index >= f_info->non_flag_arguments_c) {
 		return;
 	}
 	fprintf(stream, "WARNING: Following arguments are ignored: ");
 
-	for (int i = index; i < f_info.non_flag_arguments_c; i++)
-		fprintf(stream, "\"%s\"%c", f_info.non_flag_arguments[i],
-		        i == f_info.non_flag_arguments_c - 1 ? '.' : ' ');
+	for (int i = index; i < f_info->non_flag_arguments_c; i++)
+		fprintf(stream, "\"%s\"%c", f_info->non_flag_arguments[i],
+		        i == f_info->non_flag_arguments_c - 1 ? '.' : ' ');
 	fprintf(stream, "\n");
 }
 
 SPL_FLAG_DEF void
-spl_flag_print_help(FILE *stream)
+spl_flag_info_free(spl_flag_info *f_info)
 {
-	for (int i = 0; i < spl_flag_c; i++) {
-		fprintf(stream, "    ");
-
-		/* flag value */
-		if (spl_flag[i].short_hand != ' ')
-			fprintf(stream, "-%c, ", spl_flag[i].short_hand);
-		if (spl_flag[i].long_hand[0] != '\0')
-			fprintf(stream, "--%s, ", spl_flag[i].long_hand);
-
-		/* default value */
-		switch (spl_flag[i].type) {
-		case SPL_FLAG_TYPE_TOGGLE:
-			fprintf(stream, "(Default: %s)",
-			        spl_flag[i].def_value.tog_num == 0 ?
-			                SPL_FLAG_TOGGLE_0_STR :
-			                SPL_FLAG_TOGGLE_1_STR);
-			break;
-		case SPL_FLAG_TYPE_INT:
-			fprintf(stream, "(Default: %d)",
-			        spl_flag[i].def_value.tog_num);
-			break;
-		case SPL_FLAG_TYPE_FLOAT:
-			fprintf(stream,
-			        "(Default: %0." SPL_FLAG_FLOAT_PRECISION "f)",
-			        spl_flag[i].def_value.float_num);
-			break;
-		case SPL_FLAG_TYPE_STR:
-			if (spl_flag[i].def_value.str[0] != '\0')
-				fprintf(stream, "(Default: '%s')",
-				        spl_flag[i].def_value.str);
-		}
+	free(f_info->mem);
+	memset(f_info, 0, sizeof(*f_info));
+}
+
+/* Writes the flag and default value part of the help line of `flag` (e.g.
+ * "-h, --help, (Default: Off)") into `buf`. Returns its length. */
+static int
+spl_flag__help_prefix(const spl_flag_entry *flag, char *buf, size_t size)
+{
+	int len = 0;
+
+	/* flag value */
+	if (flag->short_hand != ' ')
+		len += snprintf(buf + len, size - len, "-%c, ",
+		                flag->short_hand);
+	if (flag->long_hand[0] != '\0')
+		len += snprintf(buf + len, size - len, "--%s, ",
+		                flag->long_hand);
+
+	/* default value */
+	switch (flag->type) {
+	case SPL_FLAG_TYPE_TOGGLE:
+		len += snprintf(buf + len, size - len, "(Default: %s)",
+		                flag->def_value.tog_num == 0 ?
+		                        SPL_FLAG_TOGGLE_0_STR :
+		                        SPL_FLAG_TOGGLE_1_STR);
+		break;
+	case SPL_FLAG_TYPE_INT:
+		len += snprintf(buf + len, size - len, "(Default: %d)",
+		                flag->def_value.tog_num);
+		break;
+	case SPL_FLAG_TYPE_FLOAT:
+		len += snprintf(buf + len, size - len,
+		                "(Default: %0." SPL_FLAG_FLOAT_PRECISION "f)",
+		                flag->def_value.float_num);
+		break;
+	case SPL_FLAG_TYPE_STR:
+		if (flag->def_value.str[0] != '\0')
+			len += snprintf(buf + len, size - len,
+			                "(Default: '%s')", flag->def_value.str);
+	}
+
+	return len;
+}
+
+/*
+ * Renders the help message of the `flags_c` entries of `flags` into a single
+ * dynamically allocated string with the info of every flag aligned on the same
+ * column. `*len` is filled with its length.
+ *
+ * Returns NULL if the string couldn't be allocated.
+ */
+static char *
+spl_flag__render_help(const spl_flag_entry *flags, int flags_c, size_t *len)
+{
+	/* Enough for the longest short hand, long hand and default value */
+	char   prefix[2048];
+	int    width = 0;
+	size_t size  = 1;
+	char  *help, *p;
+
+	/* Compute the column width and an upper bound of the size */
+	for (int i = 0; i < flags_c; i++) {
+		int prefix_len = spl_flag__help_prefix(&flags[i], prefix,
+		                                       sizeof(prefix));
+		if (prefix_len > width)
+			width = prefix_len;
+		size += strlen(flags[i].info);
+	}
+	size += (size_t)flags_c * (4 + width + 2 + 1);
+
+	help = (char *)malloc(size);
+	if (!help)
+		return NULL;
+
+	p = help;
+	for (int i = 0; i < flags_c; i++) {
+		int prefix_len = spl_flag__help_prefix(&flags[i], prefix,
+		                                       sizeof(prefix));
+
+		memcpy(p, "    ", 4);
+		p += 4;
+		memcpy(p, prefix, prefix_len);
+		p += prefix_len;
 
 		/* info */
-		if (spl_flag[i].info[0] != '\0')
-			fprintf(stream, "\t%s", spl_flag[i].info);
+		if (flags[i].info[0] != '\0') {
+			size_t info_len = strlen(flags[i].info);
 
-		fprintf(stream, "\n");
+			memset(p, ' ', width - prefix_len + 2);
+			p += width - prefix_len + 2;
+			memcpy(p, flags[i].info, info_len);
+			p += info_len;
+		}
+
+		*p++ = '\n';
+	}
+	*p = '\0';
+
+	if (len)
+		*len = p - help;
+	return help;
+}
+
+/* Outputs `str` with every character that isn't valid in a shell function
+ * name replaced by '_'. */
+static void
+spl_flag__print_ident(const char *str, FILE *stream)
+{
+	for (; *str; str++) {
+		if ((*str >= 'a' && *str <= 'z') || (*str >= 'A' && *str <= 'Z') ||
+		    (*str >= '0' && *str <= '9'))
+			fputc(*str, stream);
+		else
+			fputc('_', stream);
+	}
+}
+
+/* Outputs every flag of the `flags_c` entries of `flags` separated by spaces
+ * for the bash 'compgen -W' word list. */
+static void
+spl_flag__print_bash_words(const spl_flag_entry *flags, int flags_c,
+                           FILE *stream)
+{
+	for (int i = 0; i < flags_c; i++) {
+		if (flags[i].short_hand != ' ')
+			fprintf(stream, "-%c ", flags[i].short_hand);
+		if (flags[i].long_hand[0] != '\0')
+			fprintf(stream, "--%s ", flags[i].long_hand);
+	}
+}
+
+/* Outputs `str` escaped to be used inside a single-quoted zsh string. If
+ * `is_spec` is non-zero, characters special to an '_arguments' spec
+ * description are escaped too. */
+static void
+spl_flag__print_zsh_desc(const char *str, int is_spec, FILE *stream)
+{
+	for (; *str; str++) {
+		if (*str == '\'')
+			fputs("'\\''", stream);
+		else if (is_spec && (*str == '[' || *str == ']' ||
+		                     *str == ':' || *str == '\\'))
+			fprintf(stream, "\\%c", *str);
+		else
+			fputc(*str, stream);
+	}
+}
+
+/* Outputs one zsh '_arguments' spec per flag of the `flags_c` entries of
+ * `flags`, each indented with `indent` tabs and ending in a line
+ * continuation. */
+static void
+spl_flag__print_zsh_specs(const spl_flag_entry *flags, int flags_c,
+                          int indent, FILE *stream)
+{
+	for (int i = 0; i < flags_c; i++) {
+		int has_short = flags[i].short_hand != ' ';
+		int has_long  = flags[i].long_hand[0] != '\0';
+		int has_value = flags[i].type != SPL_FLAG_TYPE_TOGGLE;
+
+		if (!has_short && !has_long)
+			continue;
+		for (int j = 0; j < indent; j++)
+			fputc('\t', stream);
+
+		if (has_short && has_long)
+			fprintf(stream, "'(-%c --%s)'{-%c%s,--%s%s}'",
+			        flags[i].short_hand, flags[i].long_hand,
+			        flags[i].short_hand, has_value ? "+" : "",
+			        flags[i].long_hand, has_value ? "=" : "");
+		else if (has_short)
+			fprintf(stream, "'-%c%s", flags[i].short_hand,
+			        has_value ? "+" : "");
+		else
+			fprintf(stream, "'--%s%s", flags[i].long_hand,
+			        has_value ? "=" : "");
+
+		fputc('[', stream);
+		spl_flag__print_zsh_desc(flags[i].info, 1, stream);
+		fprintf(stream, "]%s' \\\n", has_value ? ":value: " : "");
+	}
+}
+
+/* Outputs the completion script of the `flags_c` entries of `flags`. */
+static void
+spl_flag__print_completion(const spl_flag_entry *flags, int flags_c,
+                           const char *prog, spl_flag_shell shell,
+                           FILE *stream)
+{
+	switch (shell) {
+	case SPL_FLAG_SHELL_BASH:
+		fputc('_', stream);
+		spl_flag__print_ident(prog, stream);
+		fprintf(stream, "_complete()\n"
+		                "{\n"
+		                "\tlocal cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+		                "\tCOMPREPLY=($(compgen -W \"");
+		spl_flag__print_bash_words(flags, flags_c, stream);
+		fprintf(stream, "\" -- \"$cur\"))\n"
+		                "}\n"
+		                "complete -o default -F _");
+		spl_flag__print_ident(prog, stream);
+		fprintf(stream, "_complete %s\n", prog);
+		break;
+	case SPL_FLAG_SHELL_ZSH:
+		fprintf(stream, "#compdef %s\n\n_arguments -s \\\n", prog);
+		spl_flag__print_zsh_specs(flags, flags_c, 1, stream);
+		fprintf(stream, "\t'*:file:_files'\n");
+		break;
+	}
+}
+
+static int
+spl_flag__long_hand_cmp(const void *a, const void *b)
+{
+	return strcmp((*(const spl_flag_entry *const *)a)->long_hand,
+	              (*(const spl_flag_entry *const *)b)->long_hand);
+}
+
+/* Returns a dynamically allocated array of pointers to the entries of `flags`
+ * having a long hand, sorted by it. `*idx_c` is filled with its length. */
+static spl_flag_entry **
+spl_flag__long_idx(spl_flag_entry *flags, int flags_c, int *idx_c)
+{
+	spl_flag_entry **idx;
+
+	idx = (spl_flag_entry **)malloc((flags_c ? flags_c : 1) *
+	                                sizeof(*idx));
+	if (!idx)
+		return NULL;
+
+	*idx_c = 0;
+	for (int i = 0; i < flags_c; i++) {
+		if (flags[i].long_hand[0] != '\0')
+			idx[(*idx_c)++] = &flags[i];
+	}
+	qsort(idx, *idx_c, sizeof(*idx), spl_flag__long_hand_cmp);
+
+	return idx;
+}
+
+/* Outputs the flags completing `word` one per line, using the sorted `idx`
+ * for the long flags. Returns the number of candidates. */
+static int
+spl_flag__complete(const spl_flag_entry *flags, int flags_c,
+                   spl_flag_entry *const *idx, int idx_c, const char *word,
+                   FILE *stream)
+{
+	const char *prefix;
+	size_t      prefix_len;
+	int         lo = 0, hi = idx_c;
+	int         candidates_c = 0;
+
+	if (word[0] != '-')
+		return 0;
+
+	/* A lone dash can still become any short flag */
+	if (word[1] == '\0') {
+		for (int i = 0; i < flags_c; i++) {
+			if (flags[i].short_hand != ' ') {
+				fprintf(stream, "-%c\n", flags[i].short_hand);
+				candidates_c++;
+			}
+		}
+		prefix = "";
+	} else if (word[1] == '-') {
+		prefix = word + 2;
+	} else {
+		return 0;
+	}
+	prefix_len = strlen(prefix);
+
+	/* Binary search the first long hand not less than the prefix, every
+	 * match follows it */
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (strcmp(idx[mid]->long_hand, prefix) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (; lo < idx_c && !strncmp(idx[lo]->long_hand, prefix, prefix_len);
+	     lo++) {
+		fprintf(stream, "--%s\n", idx[lo]->long_hand);
+		candidates_c++;
 	}
+
+	return candidates_c;
 }
 
+#ifndef SPL_FLAG_NO_GLOBAL
+SPL_FLAG_DEF void
+spl_flag_print_help(FILE *stream)
+{
+	size_t len;
+	char  *help = spl_flag__render_help(spl_flag, spl_flag_c, &len);
+
+	if (!help)
+		return;
+	fwrite(help, 1, len, stream);
+	free(help);
+}
+
+SPL_FLAG_DEF void
+spl_flag_print_completion(const char *prog, spl_flag_shell shell,
+                          FILE *stream)
+{
+	spl_flag__print_completion(spl_flag, spl_flag_c, prog, shell, stream);
+}
+
+SPL_FLAG_DEF void
+spl_flag_complete_argv(int argc, char **argv)
+{
+	spl_flag_entry **idx;
+	int              idx_c;
+
+	if (argc < 2 || strcmp(argv[1], SPL_FLAG_COMPLETE_ARG) != 0)
+		return;
+
+	idx = spl_flag__long_idx(spl_flag, spl_flag_c, &idx_c);
+	if (idx && argc > 2)
+		spl_flag__complete(spl_flag, spl_flag_c, idx, idx_c,
+		                   argv[argc - 1], stdout);
+	free(idx);
+	exit(EXIT_SUCCESS);
+}
+#endif /* SPL_FLAG_NO_GLOBAL */
+
 SPL_FLAG_DEF int
-spl_flag_print_gotchas(spl_flag_info f_info, FILE *stream)
+spl_flag_print_gotchas(const spl_flag_info *f_info, FILE *stream)
 {
 	int ret_value = 0;
 
+	if (f_info->err & SPL_FLAG_ERR_NO_MEM) {
+		fprintf(stream, "Not enough memory to parse the flags\n");
+		ret_value = 1;
+	}
+
 	/* Checking for an empty valued flag */
-	if (f_info.non_value_flag_long != NULL) {
+	if (f_info->non_value_flag_long != NULL) {
 		fprintf(stream, "No value given on the long flag '%s'\n",
-		        f_info.non_value_flag_long);
+		        f_info->non_value_flag_long);
 		ret_value = 1;
 	}
-	if (f_info.non_value_flag_short != '\0') {
+	if (f_info->non_value_flag_short != '\0') {
 		fprintf(stream, "No value given on the short flag '%c'\n",
-		        f_info.non_value_flag_short);
+		        f_info->non_value_flag_short);
 		ret_value = 1;
 	}
 
 	/* Check if any not defined or non-flag arguments are passed */
-	if (f_info.non_defined_flags_long_c > 0) {
+	if (f_info->non_defined_flags_long_c > 0) {
 		fprintf(stream, "Following long flags are undefined: ");
-		for (int i = 0; i < f_info.non_defined_flags_long_c; i++)
+		for (int i = 0; i < f_info->non_defined_flags_long_c; i++)
 			fprintf(stream, "%s ",
-			        f_info.non_defined_flags_long[i]);
+			        f_info->non_defined_flags_long[i]);
 		fprintf(stream, "\n");
 		ret_value = 1;
 	}
-	if (f_info.non_defined_flags_short_c > 0) {
+	if (f_info->non_defined_flags_short_c > 0) {
 		fprintf(stream, "Following short flags are undefined: ");
-		for (int i = 0; i < f_info.non_defined_flags_short_c; i++)
+		for (int i = 0; i < f_info->non_defined_flags_short_c; i++)
 			fprintf(stream, "%c ",
-			        f_info.non_defined_flags_short[i]);
+			        f_info->non_defined_flags_short[i]);
 		fprintf(stream, "\n");
 		ret_value = 1;
 	}
@@ -673,6 +1344,355 @@ spl_flag_print_gotchas(spl_flag_info f_info, FILE *stream)
 	return ret_value;
 }
 
+SPL_FLAG_DEF void
+spl_flag_set_init(spl_flag_set *set)
+{
+	memset(set, 0, sizeof(*set));
+}
+
+SPL_FLAG_DEF void
+spl_flag_set_free(spl_flag_set *set)
+{
+	free(set->flags);
+	free(set->help);
+	free(set->long_idx);
+	free(set->info.mem);
+	memset(set, 0, sizeof(*set));
+}
+
+/* Returns a zeroed entry at the end of the set, growing it if needed. NULL is
+ * returned if the set couldn't grow. */
+static spl_flag_entry *
+spl_flag__set_add(spl_flag_set *set)
+{
+	if (set->flags_c == set->flags_cap) {
+		int             cap = set->flags_cap ? set->flags_cap * 2 : 8;
+		spl_flag_entry *flags;
+
+		flags = (spl_flag_entry *)realloc(set->flags,
+		                                  cap * sizeof(*flags));
+		if (!flags)
+			return NULL;
+		set->flags     = flags;
+		set->flags_cap = cap;
+	}
+
+	/* The cached help message and index no longer cover every flag */
+	free(set->help);
+	set->help = NULL;
+	free(set->long_idx);
+	set->long_idx = NULL;
+
+	memset(&set->flags[set->flags_c], 0, sizeof(spl_flag_entry));
+	return &set->flags[set->flags_c++];
+}
+
+SPL_FLAG_DEF int
+spl_flag_set_toggle(spl_flag_set *set, int *f_toggle, const char short_hand,
+                    const char *long_hand, const char *info)
+{
+	spl_flag_entry *entry = spl_flag__set_add(set);
+	if (!entry)
+		return -1;
+
+	spl_flag__fill(entry, SPL_FLAG_TYPE_TOGGLE, (void *)f_toggle,
+	               short_hand, long_hand, info);
+	return 0;
+}
+
+SPL_FLAG_DEF int
+spl_flag_set_int(spl_flag_set *set, int *f_int, const char short_hand,
+                 const char *long_hand, const char *info)
+{
+	spl_flag_entry *entry = spl_flag__set_add(set);
+	if (!entry)
+		return -1;
+
+	spl_flag__fill(entry, SPL_FLAG_TYPE_INT, (void *)f_int, short_hand,
+	               long_hand, info);
+	return 0;
+}
+
+SPL_FLAG_DEF int
+spl_flag_set_float(spl_flag_set *set, float *f_float, const char short_hand,
+                   const char *long_hand, const char *info)
+{
+	spl_flag_entry *entry = spl_flag__set_add(set);
+	if (!entry)
+		return -1;
+
+	spl_flag__fill(entry, SPL_FLAG_TYPE_FLOAT, (void *)f_float,
+	               short_hand, long_hand, info);
+	return 0;
+}
+
+SPL_FLAG_DEF int
+spl_flag_set_str(spl_flag_set *set, char **f_str, const char short_hand,
+                 const char *long_hand, const char *info)
+{
+	spl_flag_entry *entry = spl_flag__set_add(set);
+	if (!entry)
+		return -1;
+
+	spl_flag__fill(entry, SPL_FLAG_TYPE_STR, (void *)f_str, short_hand,
+	               long_hand, info);
+	return 0;
+}
+
+SPL_FLAG_DEF const spl_flag_info *
+spl_flag_set_parse(spl_flag_set *set, int argc, char **argv)
+{
+	spl_flag__parse(set->flags, set->flags_c, argc, argv, &set->info);
+	return &set->info;
+}
+
+SPL_FLAG_DEF const char *
+spl_flag_set_help(spl_flag_set *set, size_t *len)
+{
+	if (!set->help)
+		set->help = spl_flag__render_help(set->flags, set->flags_c,
+		                                  &set->help_len);
+	if (len)
+		*len = set->help ? set->help_len : 0;
+	return set->help;
+}
+
+SPL_FLAG_DEF void
+spl_flag_set_print_help(spl_flag_set *set, FILE *stream)
+{
+	size_t      len;
+	const char *help = spl_flag_set_help(set, &len);
+
+	if (help)
+		fwrite(help, 1, len, stream);
+}
+
+SPL_FLAG_DEF void
+spl_flag_set_print_completion(spl_flag_set *set, const char *prog,
+                              spl_flag_shell shell, FILE *stream)
+{
+	spl_flag__print_completion(set->flags, set->flags_c, prog, shell,
+	                           stream);
+}
+
+SPL_FLAG_DEF int
+spl_flag_set_complete(spl_flag_set *set, const char *word, FILE *stream)
+{
+	if (!set->long_idx) {
+		set->long_idx = spl_flag__long_idx(set->flags, set->flags_c,
+		                                   &set->long_idx_c);
+		if (!set->long_idx)
+			return -1;
+	}
+
+	return spl_flag__complete(set->flags, set->flags_c, set->long_idx,
+	                          set->long_idx_c, word, stream);
+}
+
+SPL_FLAG_DEF void
+spl_flag_set_complete_argv(spl_flag_set *set, int argc, char **argv)
+{
+	if (argc < 2 || strcmp(argv[1], SPL_FLAG_COMPLETE_ARG) != 0)
+		return;
+
+	if (argc > 2)
+		spl_flag_set_complete(set, argv[argc - 1], stdout);
+	exit(EXIT_SUCCESS);
+}
+
+SPL_FLAG_DEF const spl_flag_cmd *
+spl_flag_cmd_find(const spl_flag_cmd *cmds, int cmds_c, const char *name)
+{
+	for (int i = 0; i < cmds_c; i++) {
+		if (strcmp(cmds[i].name, name) == 0)
+			return &cmds[i];
+	}
+
+	return NULL;
+}
+
+SPL_FLAG_DEF const spl_flag_cmd *
+spl_flag_cmd_parse(const spl_flag_cmd *cmds, int cmds_c, spl_flag_set *set,
+                   void *data, int argc, char **argv)
+{
+	const spl_flag_cmd *cmd;
+
+	if (argc < 2)
+		return NULL;
+
+	cmd = spl_flag_cmd_find(cmds, cmds_c, argv[1]);
+	if (!cmd)
+		return NULL;
+
+	/* Only the selected subcommand gets to register its flags */
+	if (cmd->reg)
+		cmd->reg(set, data);
+
+	spl_flag_set_parse(set, argc - 1, argv + 1);
+	return cmd;
+}
+
+SPL_FLAG_DEF void
+spl_flag_cmd_print_help(const spl_flag_cmd *cmds, int cmds_c, FILE *stream)
+{
+	for (int i = 0; i < cmds_c; i++) {
+		fprintf(stream, "    %s", cmds[i].name);
+		if (cmds[i].info && cmds[i].info[0] != '\0')
+			fprintf(stream, "\t%s", cmds[i].info);
+		fprintf(stream, "\n");
+	}
+}
+
+SPL_FLAG_DEF void
+spl_flag_cmd_print_completion(const spl_flag_cmd *cmds, int cmds_c,
+                              void *data, const char *prog,
+                              spl_flag_shell shell, FILE *stream)
+{
+	switch (shell) {
+	case SPL_FLAG_SHELL_BASH:
+		fputc('_', stream);
+		spl_flag__print_ident(prog, stream);
+		fprintf(stream, "_complete()\n"
+		                "{\n"
+		                "\tlocal cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+		                "\tif [ \"$COMP_CWORD\" -eq 1 ]; then\n"
+		                "\t\tCOMPREPLY=($(compgen -W \"");
+		for (int i = 0; i < cmds_c; i++)
+			fprintf(stream, "%s ", cmds[i].name);
+		fprintf(stream, "\" -- \"$cur\"))\n"
+		                "\t\treturn\n"
+		                "\tfi\n"
+		                "\tcase \"${COMP_WORDS[1]}\" in\n");
+		break;
+	case SPL_FLAG_SHELL_ZSH:
+		fprintf(stream, "#compdef %s\n\nlocal -a cmds\ncmds=(\n", prog);
+		for (int i = 0; i < cmds_c; i++) {
+			fprintf(stream, "\t'%s:", cmds[i].name);
+			if (cmds[i].info)
+				spl_flag__print_zsh_desc(cmds[i].info, 0,
+				                         stream);
+			fprintf(stream, "'\n");
+		}
+		fprintf(stream, ")\n\n"
+		                "if (( CURRENT == 2 )); then\n"
+		                "\t_describe 'command' cmds\n"
+		                "\treturn\n"
+		                "fi\n\n"
+		                "shift words\n"
+		                "(( CURRENT-- ))\n"
+		                "case $words[1] in\n");
+		break;
+	}
+
+	/* One case per subcommand, registered only for the generation */
+	for (int i = 0; i < cmds_c; i++) {
+		spl_flag_set set;
+
+		spl_flag_set_init(&set);
+		if (cmds[i].reg)
+			cmds[i].reg(&set, data);
+
+		switch (shell) {
+		case SPL_FLAG_SHELL_BASH:
+			fprintf(stream, "\t%s) COMPREPLY=($(compgen -W \"",
+			        cmds[i].name);
+			spl_flag__print_bash_words(set.flags, set.flags_c,
+			                           stream);
+			fprintf(stream, "\" -- \"$cur\")) ;;\n");
+			break;
+		case SPL_FLAG_SHELL_ZSH:
+			fprintf(stream, "%s)\n\t_arguments -s \\\n",
+			        cmds[i].name);
+			spl_flag__print_zsh_specs(set.flags, set.flags_c, 2,
+			                          stream);
+			fprintf(stream, "\t\t'*:file:_files'\n\t;;\n");
+			break;
+		}
+
+		spl_flag_set_free(&set);
+	}
+
+	switch (shell) {
+	case SPL_FLAG_SHELL_BASH:
+		fprintf(stream, "\tesac\n"
+		                "}\n"
+		                "complete -o default -F _");
+		spl_flag__print_ident(prog, stream);
+		fprintf(stream, "_complete %s\n", prog);
+		break;
+	case SPL_FLAG_SHELL_ZSH:
+		fprintf(stream, "esac\n");
+		break;
+	}
+}
+
+SPL_FLAG_DEF void
+spl_flag_cmd_complete_argv(const spl_flag_cmd *cmds, int cmds_c, void *data,
+                           int argc, char **argv)
+{
+	const spl_flag_cmd *cmd;
+	spl_flag_set        set;
+
+	if (argc < 2 || strcmp(argv[1], SPL_FLAG_COMPLETE_ARG) != 0)
+		return;
+
+	/* Completing the subcommand itself */
+	if (argc == 3) {
+		size_t word_len = strlen(argv[2]);
+
+		for (int i = 0; i < cmds_c; i++) {
+			if (!strncmp(cmds[i].name, argv[2], word_len))
+				printf("%s\n", cmds[i].name);
+		}
+		exit(EXIT_SUCCESS);
+	}
+
+	if (argc < 3 || !(cmd = spl_flag_cmd_find(cmds, cmds_c, argv[2])))
+		exit(EXIT_SUCCESS);
+
+	spl_flag_set_init(&set);
+	if (cmd->reg)
+		cmd->reg(&set, data);
+	spl_flag_set_complete(&set, argv[argc - 1], stdout);
+	spl_flag_set_free(&set);
+	exit(EXIT_SUCCESS);
+}
+
+SPL_FLAG_DEF void
+spl_flag_print_complete_hook(const char *prog, spl_flag_shell shell,
+                             FILE *stream)
+{
+	switch (shell) {
+	case SPL_FLAG_SHELL_BASH:
+		fputc('_', stream);
+		spl_flag__print_ident(prog, stream);
+		fprintf(stream,
+		        "_complete()\n"
+		        "{\n"
+		        "\tCOMPREPLY=($(%s " SPL_FLAG_COMPLETE_ARG
+		        " \"${COMP_WORDS[@]:1:COMP_CWORD}\"))\n"
+		        "}\n"
+		        "complete -o default -F _",
+		        prog);
+		spl_flag__print_ident(prog, stream);
+		fprintf(stream, "_complete %s\n", prog);
+		break;
+	case SPL_FLAG_SHELL_ZSH:
+		fprintf(stream,
+		        "#compdef %s\n\n"
+		        "local -a reply\n"
+		        "reply=(${(f)\"$(%s " SPL_FLAG_COMPLETE_ARG
+		        " \"${(@)words[2,CURRENT]}\")\"})\n"
+		        "if (( ${#reply} )); then\n"
+		        "\tcompadd -a reply\n"
+		        "else\n"
+		        "\t_files\n"
+		        "fi\n",
+		        prog, prog);
+		break;
+	}
+}
+
 #endif /* SPL_FLAG_H */
 
 /*
@@ -0,0 +1,597 @@
+/*
+ ===============================================================================
+ |                                  spl_map.h                                  |
+ |                     https://github.com/mrsafalpiya/spl                      |
+ |                                                                             |
+ |                  Open-addressing hash map with string keys                  |
+ |                                                                             |
+ |                  No warranty implied; Use at your own risk                  |
+ |                  See end of file for license information.                   |
+ ===============================================================================
+ */
+
+/*
+ ===============================================================================
+ |                               Version History                               |
+ ===============================================================================
+ *
+ - v0.1 (Current)
+ */
+
+/*
+ ===============================================================================
+ |                                    Usage                                    |
+ ===============================================================================
+ *
+ * Do this:
+ *
+ *         #define SPL_MAP_IMPL
+ *
+ * before you include this file in *one* C or C++ file to create the
+ * implementation.
+ *
+ * The map is a Swiss table: besides the array of slots, each slot has a
+ * control byte telling whether it is empty, deleted or full and, when full, 7
+ * bits of the hash of its key. Lookups compare the control bytes of a group of
+ * 16 slots at once and only look at the slots whose bits match, so a miss
+ * usually touches no key at all.
+ *
+ * Keys are string views: a pointer and a length, not copied by the map. They
+ * must stay valid and unchanged while in it. Values are 'void *'; a set just
+ * stores NULL.
+ *
+ *         spl_map m;
+ *         void  **v;
+ *
+ *         spl_map_init(&m, 0);
+ *         spl_map_put(&m, "key", -1, ptr);
+ *         if ((v = spl_map_get(&m, "key", -1)))
+ *                 use(*v);
+ *         spl_map_free(&m);
+ */
+
+/*
+ ===============================================================================
+ |                              HEADER-FILE MODE                               |
+ ===============================================================================
+ */
+
+#ifndef SPL_MAP_H
+#define SPL_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ ===============================================================================
+ |                                   Options                                   |
+ ===============================================================================
+ */
+
+/* = SPL_MAP = */
+#ifndef SPL_MAP_DEF
+#define SPL_MAP_DEF /* You may want `static` or `static inline` here */
+#endif
+
+/* Groups of control bytes are matched with SSE2 when the compiler targets it
+ * (always on x86-64). Define 'SPL_MAP_NO_SIMD' to always use the plain C
+ * version. */
+
+/*
+ ===============================================================================
+ |                                    Data                                     |
+ ===============================================================================
+ */
+
+typedef struct {
+	const char *key;
+	size_t      key_len;
+	uint64_t    hash;
+	void       *val;
+} spl_map_slot;
+
+typedef struct {
+	spl_map_slot *slots;
+	uint8_t      *ctrl;        /* A control byte per slot */
+	size_t        cap;         /* Slots; a power of 2, 0 or at least 16 */
+	size_t        len;         /* Keys */
+	size_t        growth_left; /* Empty slots to fill before growing */
+} spl_map;
+
+/*
+ ===============================================================================
+ |                            Function Declarations                            |
+ ===============================================================================
+ */
+
+/* Initializes `map` with room for `cap` keys without growing. Returns 0 on
+ * success or -1 on allocation failure. A zeroed map is also a valid empty
+ * one. */
+SPL_MAP_DEF int
+spl_map_init(spl_map *map, size_t cap);
+
+/* Frees the memory of `map`, not its keys or values. */
+SPL_MAP_DEF void
+spl_map_free(spl_map *map);
+
+/* Removes every key of `map`, keeping its memory. */
+SPL_MAP_DEF void
+spl_map_clear(spl_map *map);
+
+/*
+ * Returns a pointer to the value of `key` in `map`, or NULL if absent. The
+ * pointer stays valid until the next insertion.
+ *
+ * `len` is the length of the `key`. Pass -1 if you want the function to
+ * calculate it.
+ */
+SPL_MAP_DEF void **
+spl_map_get(const spl_map *map, const char *key, int len);
+
+/*
+ * Sets the value of `key` in `map` to `val`, inserting it if absent. The map
+ * grows when 7/8 full.
+ *
+ * `len` is the length of the `key`. Pass -1 if you want the function to
+ * calculate it.
+ *
+ * Returns 1 if inserted, 0 if replaced or -1 on allocation failure.
+ */
+SPL_MAP_DEF int
+spl_map_put(spl_map *map, const char *key, int len, void *val);
+
+/*
+ * Removes `key` from `map`.
+ *
+ * `len` is the length of the `key`. Pass -1 if you want the function to
+ * calculate it.
+ *
+ * Returns 1 if removed or 0 if absent.
+ */
+SPL_MAP_DEF int
+spl_map_del(spl_map *map, const char *key, int len);
+
+/*
+ * Iterates over the keys of `map`, in no particular order:
+ *
+ *         size_t        it = 0;
+ *         spl_map_slot *slot;
+ *
+ *         while ((slot = spl_map_next(&m, &it)))
+ *                 printf("%.*s\n", (int)slot->key_len, slot->key);
+ *
+ * `*it` must start at 0. Returns the next full slot or NULL at the end. Keys
+ * must not be inserted while iterating; the current one may be removed.
+ */
+SPL_MAP_DEF spl_map_slot *
+spl_map_next(const spl_map *map, size_t *it);
+
+/* Hashes `len` bytes of `data` with `seed`: the wyhash function, fast and of
+ * good quality but not cryptographic. The result depends on the byte order of
+ * the machine. */
+SPL_MAP_DEF uint64_t
+spl_map_hash(const void *data, size_t len, uint64_t seed);
+
+#endif /* SPL_MAP_H */
+
+/*
+ ===============================================================================
+ |                             IMPLEMENTATION MODE                             |
+ ===============================================================================
+ */
+
+#ifdef SPL_MAP_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(SPL_MAP_NO_SIMD) && defined(__SSE2__)
+#define SPL_MAP__SSE2
+#include <emmintrin.h>
+#endif
+
+/* Control bytes. Full slots store the low 7 bits of their hash. */
+#define SPL_MAP__EMPTY   0x80
+#define SPL_MAP__DELETED 0xfe
+#define SPL_MAP__GROUP   16
+
+/*
+ ===============================================================================
+ |                          Function Implementations                           |
+ ===============================================================================
+ */
+
+/* = HASHING = */
+
+/* The 128 bit product of `*a` and `*b`, low half in `*a` */
+static inline void
+spl_map__mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = (__uint128_t)*a * *b;
+
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32;
+	uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t
+spl_map__mix(uint64_t a, uint64_t b)
+{
+	spl_map__mum(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t
+spl_map__r8(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline uint64_t
+spl_map__r4(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, 4);
+	return v;
+}
+
+SPL_MAP_DEF uint64_t
+spl_map_hash(const void *data, size_t len, uint64_t seed)
+{
+	static const uint64_t s[4] = { 0x2d358dccaa6c78a5ull,
+		                       0x8bb84b93962eacc9ull,
+		                       0x4b33a62ed433d4a3ull,
+		                       0x4d5a2da51de1aa47ull };
+	const uint8_t        *p    = (const uint8_t *)data;
+	uint64_t              a, b;
+	size_t                i;
+
+	seed ^= spl_map__mix(seed ^ s[0], s[1]);
+	if (len <= 16) {
+		if (len >= 4) {
+			a = spl_map__r4(p) << 32 |
+			    spl_map__r4(p + ((len >> 3) << 2));
+			b = spl_map__r4(p + len - 4) << 32 |
+			    spl_map__r4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = (uint64_t)p[0] << 16 | (uint64_t)p[len >> 1] << 8 |
+			    p[len - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		i = len;
+		if (i > 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = spl_map__mix(spl_map__r8(p) ^ s[1],
+				                    spl_map__r8(p + 8) ^ seed);
+				see1 = spl_map__mix(spl_map__r8(p + 16) ^ s[2],
+				                    spl_map__r8(p + 24) ^ see1);
+				see2 = spl_map__mix(spl_map__r8(p + 32) ^ s[3],
+				                    spl_map__r8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = spl_map__mix(spl_map__r8(p) ^ s[1],
+			                    spl_map__r8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = spl_map__r8(p + i - 16);
+		b = spl_map__r8(p + i - 8);
+	}
+
+	a ^= s[1];
+	b ^= seed;
+	spl_map__mum(&a, &b);
+	return spl_map__mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+/* = GROUPS = */
+
+/* Bit i set for each control byte i of the group at `ctrl` equal to `c` */
+static inline unsigned
+spl_map__match(const uint8_t *ctrl, uint8_t c)
+{
+#ifdef SPL_MAP__SSE2
+	__m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)c)));
+#else
+	unsigned m = 0;
+
+	for (int i = 0; i < SPL_MAP__GROUP; i++)
+		m |= (unsigned)(ctrl[i] == c) << i;
+	return m;
+#endif
+}
+
+/* Bit i set for each empty or deleted control byte i of the group at `ctrl`,
+ * the only ones with the high bit set */
+static inline unsigned
+spl_map__match_free(const uint8_t *ctrl)
+{
+#ifdef SPL_MAP__SSE2
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+	unsigned m = 0;
+
+	for (int i = 0; i < SPL_MAP__GROUP; i++)
+		m |= (unsigned)(ctrl[i] >> 7) << i;
+	return m;
+#endif
+}
+
+static inline int
+spl_map__ctz(unsigned m)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(m);
+#else
+	int n = 0;
+
+	while (!(m & 1)) {
+		m >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* = TABLE = */
+
+/* Allocates `cap` empty slots. */
+static int
+spl_map__alloc(spl_map *map, size_t cap)
+{
+	/* The control bytes follow the slots in one block */
+	char *mem = (char *)malloc(cap * (sizeof(spl_map_slot) + 1));
+
+	if (!mem)
+		return -1;
+	map->slots       = (spl_map_slot *)mem;
+	map->ctrl        = (uint8_t *)mem + cap * sizeof(spl_map_slot);
+	map->cap         = cap;
+	map->len         = 0;
+	map->growth_left = cap - cap / 8;
+	memset(map->ctrl, SPL_MAP__EMPTY, cap);
+	return 0;
+}
+
+/* Returns the index of the slot of `key` (of `hash`), or -1 if absent. Groups
+ * are probed in a triangular sequence, visiting all of them, until one has an
+ * empty slot. */
+static ptrdiff_t
+spl_map__find(const spl_map *map, const char *key, size_t len, uint64_t hash)
+{
+	size_t  mask = map->cap / SPL_MAP__GROUP - 1;
+	size_t  g    = (hash >> 7) & mask;
+	uint8_t h2   = hash & 0x7f;
+
+	if (!map->cap)
+		return -1;
+	for (size_t step = 1;; g = (g + step++) & mask) {
+		const uint8_t *ctrl = map->ctrl + g * SPL_MAP__GROUP;
+		unsigned       m    = spl_map__match(ctrl, h2);
+
+		for (; m; m &= m - 1) {
+			size_t              i = g * SPL_MAP__GROUP +
+			                        spl_map__ctz(m);
+			const spl_map_slot *s = &map->slots[i];
+
+			if (s->hash == hash && s->key_len == len &&
+			    !memcmp(s->key, key, len))
+				return i;
+		}
+		if (spl_map__match(ctrl, SPL_MAP__EMPTY) || step > mask)
+			return -1;
+	}
+}
+
+/* Returns the index of the first empty or deleted slot for `hash`. There
+ * must be one. */
+static size_t
+spl_map__find_free(const spl_map *map, uint64_t hash)
+{
+	size_t   mask = map->cap / SPL_MAP__GROUP - 1;
+	size_t   g    = (hash >> 7) & mask;
+	unsigned m;
+
+	for (size_t step = 1;; g = (g + step++) & mask) {
+		m = spl_map__match_free(map->ctrl + g * SPL_MAP__GROUP);
+		if (m)
+			return g * SPL_MAP__GROUP + spl_map__ctz(m);
+	}
+}
+
+/* Moves the keys into a table of `cap` slots, dropping deleted ones. */
+static int
+spl_map__resize(spl_map *map, size_t cap)
+{
+	spl_map old = *map;
+	size_t  i, j;
+
+	if (spl_map__alloc(map, cap) < 0) {
+		*map = old;
+		return -1;
+	}
+	for (i = 0; i < old.cap; i++) {
+		if (old.ctrl[i] & 0x80)
+			continue;
+		j             = spl_map__find_free(map, old.slots[i].hash);
+		map->ctrl[j]  = old.ctrl[i];
+		map->slots[j] = old.slots[i];
+	}
+	map->len = old.len;
+	map->growth_left -= old.len;
+	free(old.slots);
+	return 0;
+}
+
+SPL_MAP_DEF int
+spl_map_init(spl_map *map, size_t cap)
+{
+	size_t n = SPL_MAP__GROUP;
+
+	/* Room for `cap` keys under the maximum load of 7/8 */
+	while (n - n / 8 < cap)
+		n *= 2;
+	return spl_map__alloc(map, n);
+}
+
+SPL_MAP_DEF void
+spl_map_free(spl_map *map)
+{
+	free(map->slots);
+	memset(map, 0, sizeof(*map));
+}
+
+SPL_MAP_DEF void
+spl_map_clear(spl_map *map)
+{
+	if (!map->cap)
+		return;
+	memset(map->ctrl, SPL_MAP__EMPTY, map->cap);
+	map->len         = 0;
+	map->growth_left = map->cap - map->cap / 8;
+}
+
+SPL_MAP_DEF void **
+spl_map_get(const spl_map *map, const char *key, int len)
+{
+	ptrdiff_t i;
+
+	if (len < 0)
+		len = strlen(key);
+
+	i = spl_map__find(map, key, len, spl_map_hash(key, len, 0));
+	return i < 0 ? NULL : &map->slots[i].val;
+}
+
+SPL_MAP_DEF int
+spl_map_put(spl_map *map, const char *key, int len, void *val)
+{
+	uint64_t  hash;
+	ptrdiff_t i;
+	size_t    j;
+
+	if (len < 0)
+		len = strlen(key);
+
+	hash = spl_map_hash(key, len, 0);
+	if ((i = spl_map__find(map, key, len, hash)) >= 0) {
+		map->slots[i].val = val;
+		return 0;
+	}
+
+	j = map->cap ? spl_map__find_free(map, hash) : 0;
+	if (!map->cap ||
+	    (map->growth_left == 0 && map->ctrl[j] == SPL_MAP__EMPTY)) {
+		/* Only rehash in place when deleted slots took the room */
+		size_t cap = !map->cap                    ? SPL_MAP__GROUP :
+		             map->len < map->cap * 7 / 16 ? map->cap :
+		                                            map->cap * 2;
+		if (spl_map__resize(map, cap) < 0)
+			return -1;
+		j = spl_map__find_free(map, hash);
+	}
+
+	if (map->ctrl[j] == SPL_MAP__EMPTY)
+		map->growth_left--;
+	map->ctrl[j]          = hash & 0x7f;
+	map->slots[j].key     = key;
+	map->slots[j].key_len = len;
+	map->slots[j].hash    = hash;
+	map->slots[j].val     = val;
+	map->len++;
+	return 1;
+}
+
+SPL_MAP_DEF int
+spl_map_del(spl_map *map, const char *key, int len)
+{
+	ptrdiff_t i;
+	uint8_t  *group;
+
+	if (len < 0)
+		len = strlen(key);
+
+	i = spl_map__find(map, key, len, spl_map_hash(key, len, 0));
+	if (i < 0)
+		return 0;
+
+	/* A probe stops at a group with an empty slot, so this one can become
+	 * empty too rather than a tombstone */
+	group = map->ctrl + (i & ~(size_t)(SPL_MAP__GROUP - 1));
+	if (spl_map__match(group, SPL_MAP__EMPTY)) {
+		map->ctrl[i] = SPL_MAP__EMPTY;
+		map->growth_left++;
+	} else {
+		map->ctrl[i] = SPL_MAP__DELETED;
+	}
+	map->len--;
+	return 1;
+}
+
+SPL_MAP_DEF spl_map_slot *
+spl_map_next(const spl_map *map, size_t *it)
+{
+	for (; *it < map->cap; (*it)++) {
+		if (!(map->ctrl[*it] & 0x80))
+			return &map->slots[(*it)++];
+	}
+	return NULL;
+}
+
+#endif /* SPL_MAP_IMPL */
+
+/*
+ ===============================================================================
+ |                 License - Public Domain (www.unlicense.org)                 |
+ ===============================================================================
+ *
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
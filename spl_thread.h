@@ -0,0 +1,639 @@
+/*
+ ===============================================================================
+ |                                spl_thread.h                                 |
+ |                     https://github.com/mrsafalpiya/spl                      |
+ |                                                                             |
+ |                          Work-stealing thread pool                          |
+ |                                                                             |
+ |                  No warranty implied; Use at your own risk                  |
+ |                  See end of file for license information.                   |
+ ===============================================================================
+ */
+
+/*
+ ===============================================================================
+ |                               Version History                               |
+ ===============================================================================
+ *
+ - v0.1 (Current)
+ */
+
+/*
+ ===============================================================================
+ |                                    Usage                                    |
+ ===============================================================================
+ *
+ * Do this:
+ *
+ *         #define SPL_THREAD_IMPL
+ *
+ * before you include this file in *one* C or C++ file to create the
+ * implementation. Link with '-pthread'. With a strict '-std=c99', also define
+ * '_POSIX_C_SOURCE' to 200809L before including any header.
+ *
+ * Each worker thread owns a deque of tasks: it pushes and pops the newest
+ * tasks at one end while idle workers steal the oldest ones, the largest
+ * pieces of work, from the other end. Tasks submitted from outside the pool go
+ * through a shared queue.
+ *
+ *         static void
+ *         upper(void *arg, size_t begin, size_t end)
+ *         {
+ *                 spl_str_toupper((char *)arg + begin, (int)(end - begin));
+ *         }
+ *
+ *         spl_thread_pool *pool = spl_thread_pool_create(0);
+ *         spl_thread_parallel_for(pool, 0, len, 1 << 16, upper, buf);
+ *         spl_thread_pool_destroy(pool);
+ */
+
+/*
+ ===============================================================================
+ |                              HEADER-FILE MODE                               |
+ ===============================================================================
+ */
+
+#ifndef SPL_THREAD_H
+#define SPL_THREAD_H
+
+#include <stddef.h>
+
+/*
+ ===============================================================================
+ |                                   Options                                   |
+ ===============================================================================
+ */
+
+/* = SPL_THREAD = */
+#ifndef SPL_THREAD_DEF
+#define SPL_THREAD_DEF /* You may want `static` or `static inline` here */
+#endif
+
+/* = SPL_THREAD_DEQUE_SIZE = */
+/* Tasks a worker's deque holds, a power of 2. A worker runs a task right away
+ * rather than pushing it on a full deque. */
+#ifndef SPL_THREAD_DEQUE_SIZE
+#define SPL_THREAD_DEQUE_SIZE 1024
+#endif
+
+/*
+ ===============================================================================
+ |                                    Data                                     |
+ ===============================================================================
+ */
+
+typedef struct spl_thread_pool spl_thread_pool;
+
+/*
+ ===============================================================================
+ |                            Function Declarations                            |
+ ===============================================================================
+ */
+
+/* Returns a pool of `threads_c` workers, or as many as there are online CPUs
+ * if 0. Returns NULL on failure. */
+SPL_THREAD_DEF spl_thread_pool *
+spl_thread_pool_create(int threads_c);
+
+/* Stops the workers of `pool` and frees it. Tasks still queued are not run;
+ * see 'spl_thread_wait()'. */
+SPL_THREAD_DEF void
+spl_thread_pool_destroy(spl_thread_pool *pool);
+
+/* Returns the number of workers of `pool`. */
+SPL_THREAD_DEF int
+spl_thread_pool_size(const spl_thread_pool *pool);
+
+/* Queues `fn(arg)` to run on `pool`. Returns 0 on success or -1 on allocation
+ * failure. */
+SPL_THREAD_DEF int
+spl_thread_submit(spl_thread_pool *pool, void (*fn)(void *arg), void *arg);
+
+/* Runs queued tasks on the calling thread too until every task submitted to
+ * `pool` has finished. */
+SPL_THREAD_DEF void
+spl_thread_wait(spl_thread_pool *pool);
+
+/*
+ * Calls `fn(arg, b, e)` over sub-ranges [b, e) covering [`begin`, `end`) in
+ * parallel and returns when all are done, the calling thread taking part.
+ *
+ * The range is halved recursively, a half being left for other workers to
+ * steal at each step, until pieces are no larger than `grain` (1 if 0). The
+ * grain is raised if needed to keep the number of pieces around 64 per worker,
+ * which balances well enough without the overhead of tiny tasks.
+ *
+ * May be called from within a task, or concurrently from several threads.
+ */
+SPL_THREAD_DEF void
+spl_thread_parallel_for(spl_thread_pool *pool, size_t begin, size_t end,
+                        size_t grain,
+                        void (*fn)(void *arg, size_t begin, size_t end),
+                        void *arg);
+
+#endif /* SPL_THREAD_H */
+
+/*
+ ===============================================================================
+ |                             IMPLEMENTATION MODE                             |
+ ===============================================================================
+ */
+
+#ifdef SPL_THREAD_IMPL
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* = TASKS = */
+
+typedef struct spl_thread__for spl_thread__for;
+
+/* A submitted function, or a piece of a 'spl_thread_parallel_for()' */
+typedef struct spl_thread__task {
+	void (*fn)(void *arg);
+	void *arg;
+	spl_thread__for         *pf; /* Non-NULL for a piece */
+	size_t                   lo, hi;
+	struct spl_thread__task *next; /* In the shared queue */
+} spl_thread__task;
+
+struct spl_thread__for {
+	void (*fn)(void *arg, size_t begin, size_t end);
+	void             *arg;
+	size_t            grain;
+	spl_thread__task *tasks;    /* Enough for every split */
+	size_t            tasks_c;  /* Taken */
+	size_t            unfinished;
+};
+
+/* Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from
+ * the top */
+typedef struct {
+	int64_t           top;
+	char              pad0[56];
+	int64_t           bottom;
+	char              pad1[56];
+	spl_thread__task *buf[SPL_THREAD_DEQUE_SIZE];
+} spl_thread__deque;
+
+typedef struct {
+	spl_thread_pool  *pool;
+	int               id;
+	pthread_t         thread;
+	spl_thread__deque deque;
+} spl_thread__worker;
+
+struct spl_thread_pool {
+	spl_thread__worker *workers;
+	int                 workers_c;
+	pthread_mutex_t     lock;   /* Protects the shared queue and sleeping */
+	pthread_cond_t      wake;
+	spl_thread__task   *head, *tail; /* Shared queue */
+	size_t              queued;     /* Tasks waiting in any queue */
+	size_t              unfinished; /* Submitted tasks not done */
+	int                 sleepers;   /* Idle workers and waiting callers */
+	int                 stop;
+};
+
+/* The worker the calling thread is, if any */
+static __thread spl_thread__worker *spl_thread__self;
+
+/*
+ ===============================================================================
+ |                          Function Implementations                           |
+ ===============================================================================
+ */
+
+/* = DEQUES = */
+
+/* Returns 0, or -1 if full. Only the owner may push. */
+static int
+spl_thread__deque_push(spl_thread__deque *d, spl_thread__task *t)
+{
+	int64_t b  = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+	int64_t tp = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+
+	if (b - tp >= SPL_THREAD_DEQUE_SIZE)
+		return -1;
+	__atomic_store_n(&d->buf[b & (SPL_THREAD_DEQUE_SIZE - 1)], t,
+	                 __ATOMIC_RELAXED);
+	__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/* Takes the newest task. Only the owner may pop. */
+static spl_thread__task *
+spl_thread__deque_pop(spl_thread__deque *d)
+{
+	int64_t           b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+	int64_t           tp;
+	spl_thread__task *t;
+
+	__atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	tp = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+	if (tp > b) {
+		__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+	t = __atomic_load_n(&d->buf[b & (SPL_THREAD_DEQUE_SIZE - 1)],
+	                    __ATOMIC_RELAXED);
+	if (tp == b) {
+		/* The last one: race the thieves for it */
+		if (!__atomic_compare_exchange_n(&d->top, &tp, tp + 1, 0,
+		                                 __ATOMIC_SEQ_CST,
+		                                 __ATOMIC_RELAXED))
+			t = NULL;
+		__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+	}
+	return t;
+}
+
+/* Takes the oldest task. Any thread may steal. */
+static spl_thread__task *
+spl_thread__deque_steal(spl_thread__deque *d)
+{
+	int64_t           tp = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+	int64_t           b;
+	spl_thread__task *t;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+	if (tp >= b)
+		return NULL;
+
+	t = __atomic_load_n(&d->buf[tp & (SPL_THREAD_DEQUE_SIZE - 1)],
+	                    __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&d->top, &tp, tp + 1, 0,
+	                                 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return NULL; /* Lost to another thief or the owner */
+	return t;
+}
+
+/* = SCHEDULING = */
+
+/* Failed attempts at taking a task before a waiting caller sleeps */
+#define SPL_THREAD__SPINS 16
+
+/* Wakes a sleeping thread, if any, after a task was queued. Sleepers check
+ * 'queued' under the lock, so one of the two sides sees the other. */
+static void
+spl_thread__wake(spl_thread_pool *pool)
+{
+	__atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+		pthread_mutex_lock(&pool->lock);
+		pthread_cond_signal(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/* Queues `t` on the deque of the calling worker, or on the shared queue from
+ * another thread. Returns -1 if the deque is full. */
+static int
+spl_thread__push(spl_thread_pool *pool, spl_thread__task *t)
+{
+	spl_thread__worker *self = spl_thread__self;
+
+	if (self && self->pool == pool) {
+		if (spl_thread__deque_push(&self->deque, t) < 0)
+			return -1;
+	} else {
+		t->next = NULL;
+		pthread_mutex_lock(&pool->lock);
+		if (pool->tail)
+			pool->tail->next = t;
+		else
+			__atomic_store_n(&pool->head, t, __ATOMIC_RELAXED);
+		pool->tail = t;
+		pthread_mutex_unlock(&pool->lock);
+	}
+	spl_thread__wake(pool);
+	return 0;
+}
+
+/* Returns a task to run: the newest of the own deque, else the oldest of the
+ * shared queue, else one stolen from another worker. */
+static spl_thread__task *
+spl_thread__take(spl_thread_pool *pool)
+{
+	spl_thread__worker *self = spl_thread__self;
+	spl_thread__task   *t    = NULL;
+	int                 start;
+
+	if (!__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE))
+		return NULL;
+
+	if (self && self->pool == pool)
+		t = spl_thread__deque_pop(&self->deque);
+
+	if (!t && __atomic_load_n(&pool->head, __ATOMIC_RELAXED)) {
+		pthread_mutex_lock(&pool->lock);
+		if ((t = pool->head)) {
+			__atomic_store_n(&pool->head, t->next,
+			                 __ATOMIC_RELAXED);
+			if (!t->next)
+				pool->tail = NULL;
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	/* Victims are tried in turn from the next worker, spreading thieves */
+	start = self && self->pool == pool ? self->id + 1 : 0;
+	for (int i = 0; !t && i < pool->workers_c; i++)
+		t = spl_thread__deque_steal(
+			&pool->workers[(start + i) % pool->workers_c].deque);
+
+	if (t)
+		__atomic_sub_fetch(&pool->queued, 1, __ATOMIC_RELAXED);
+	return t;
+}
+
+/* Counts a task of `*unfinished` as done, waking the callers sleeping in
+ * 'spl_thread__help()' after the last one, as 'spl_thread__wake()' does. The
+ * waiter may return right after, so `unfinished` is not touched again. */
+static void
+spl_thread__done(spl_thread_pool *pool, size_t *unfinished)
+{
+	if (__atomic_sub_fetch(unfinished, 1, __ATOMIC_SEQ_CST) == 0 &&
+	    __atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+		pthread_mutex_lock(&pool->lock);
+		pthread_cond_broadcast(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/* Runs the range of the piece `t`, leaving the upper half of it to steal
+ * while it is larger than the grain. */
+static void
+spl_thread__run_range(spl_thread_pool *pool, spl_thread__task *t)
+{
+	spl_thread__for  *pf = t->pf;
+	spl_thread__task *half;
+	size_t            lo = t->lo, hi = t->hi, mid;
+
+	while (hi - lo > pf->grain) {
+		mid       = lo + (hi - lo) / 2;
+		half      = &pf->tasks[__atomic_fetch_add(&pf->tasks_c, 1,
+		                                          __ATOMIC_RELAXED)];
+		half->pf  = pf;
+		half->lo  = mid;
+		half->hi  = hi;
+		__atomic_add_fetch(&pf->unfinished, 1, __ATOMIC_RELAXED);
+		if (spl_thread__push(pool, half) < 0) {
+			/* Full deque; no more splitting */
+			__atomic_sub_fetch(&pf->unfinished, 1,
+			                   __ATOMIC_RELAXED);
+			break;
+		}
+		hi = mid;
+	}
+	pf->fn(pf->arg, lo, hi);
+	spl_thread__done(pool, &pf->unfinished);
+}
+
+static void
+spl_thread__run(spl_thread_pool *pool, spl_thread__task *t)
+{
+	if (t->pf) {
+		spl_thread__run_range(pool, t);
+		return;
+	}
+	t->fn(t->arg);
+	free(t);
+	spl_thread__done(pool, &pool->unfinished);
+}
+
+/* Runs tasks on the calling thread until `*unfinished` reaches 0. Once there
+ * are none left to take, the rest running elsewhere, it sleeps with the idle
+ * workers rather than taking a core from them. */
+static void
+spl_thread__help(spl_thread_pool *pool, size_t *unfinished)
+{
+	spl_thread__task *t;
+	int               misses = 0;
+
+	while (__atomic_load_n(unfinished, __ATOMIC_ACQUIRE)) {
+		if ((t = spl_thread__take(pool))) {
+			spl_thread__run(pool, t);
+			misses = 0;
+			continue;
+		}
+		if (++misses < SPL_THREAD__SPINS) {
+			sched_yield();
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		__atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n(unfinished, __ATOMIC_SEQ_CST) &&
+		       !__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST))
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		__atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		/* Pass on a wakeup meant for a task this thread leaves */
+		if (!__atomic_load_n(unfinished, __ATOMIC_SEQ_CST) &&
+		    __atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST))
+			pthread_cond_signal(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+		misses = 0;
+	}
+}
+
+static void *
+spl_thread__main(void *arg)
+{
+	spl_thread__worker *self = (spl_thread__worker *)arg;
+	spl_thread_pool    *pool = self->pool;
+	spl_thread__task   *t;
+
+	spl_thread__self = self;
+	for (;;) {
+		if ((t = spl_thread__take(pool))) {
+			spl_thread__run(pool, t);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		__atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		while (!pool->stop &&
+		       !__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST))
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		__atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		if (pool->stop) {
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/* = POOL = */
+
+SPL_THREAD_DEF spl_thread_pool *
+spl_thread_pool_create(int threads_c)
+{
+	spl_thread_pool *pool;
+	int              i;
+
+	if (threads_c <= 0) {
+		long n    = sysconf(_SC_NPROCESSORS_ONLN);
+		threads_c = n > 0 ? (int)n : 1;
+	}
+
+	pool = (spl_thread_pool *)calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+	pool->workers = (spl_thread__worker *)calloc(threads_c,
+	                                             sizeof(*pool->workers));
+	if (!pool->workers) {
+		free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+
+	for (i = 0; i < threads_c; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].id   = i;
+		if (pthread_create(&pool->workers[i].thread, NULL,
+		                   spl_thread__main, &pool->workers[i]) != 0)
+			break;
+	}
+	pool->workers_c = i;
+	if (i < threads_c) {
+		spl_thread_pool_destroy(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+SPL_THREAD_DEF void
+spl_thread_pool_destroy(spl_thread_pool *pool)
+{
+	spl_thread__task *t;
+
+	if (!pool)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (int i = 0; i < pool->workers_c; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	/* Submitted tasks left in the queues were allocated here */
+	while ((t = spl_thread__take(pool)))
+		if (!t->pf)
+			free(t);
+
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool);
+}
+
+SPL_THREAD_DEF int
+spl_thread_pool_size(const spl_thread_pool *pool)
+{
+	return pool->workers_c;
+}
+
+SPL_THREAD_DEF int
+spl_thread_submit(spl_thread_pool *pool, void (*fn)(void *arg), void *arg)
+{
+	spl_thread__task *t = (spl_thread__task *)calloc(1, sizeof(*t));
+
+	if (!t)
+		return -1;
+	t->fn  = fn;
+	t->arg = arg;
+	__atomic_add_fetch(&pool->unfinished, 1, __ATOMIC_RELAXED);
+	if (spl_thread__push(pool, t) < 0)
+		spl_thread__run(pool, t); /* Full deque */
+	return 0;
+}
+
+SPL_THREAD_DEF void
+spl_thread_wait(spl_thread_pool *pool)
+{
+	spl_thread__help(pool, &pool->unfinished);
+}
+
+SPL_THREAD_DEF void
+spl_thread_parallel_for(spl_thread_pool *pool, size_t begin, size_t end,
+                        size_t grain,
+                        void (*fn)(void *arg, size_t begin, size_t end),
+                        void *arg)
+{
+	spl_thread__for  pf;
+	spl_thread__task root;
+	size_t           n = end - begin, min_grain, pieces;
+
+	if (begin >= end)
+		return;
+
+	min_grain = n / ((size_t)pool->workers_c * 64);
+	if (grain < min_grain)
+		grain = min_grain;
+	if (grain == 0)
+		grain = 1;
+
+	/* Halving stops at pieces of more than half the grain, so each split
+	 * adds one task to at most 2n/grain pieces */
+	pieces = n / grain * 2 + 2;
+	pf.tasks = (spl_thread__task *)malloc(pieces * sizeof(*pf.tasks));
+	if (!pf.tasks) {
+		fn(arg, begin, end);
+		return;
+	}
+	pf.fn         = fn;
+	pf.arg        = arg;
+	pf.grain      = grain;
+	pf.tasks_c    = 0;
+	pf.unfinished = 1;
+
+	root.pf = &pf;
+	root.lo = begin;
+	root.hi = end;
+	spl_thread__run_range(pool, &root);
+	spl_thread__help(pool, &pf.unfinished);
+	free(pf.tasks);
+}
+
+#endif /* SPL_THREAD_IMPL */
+
+/*
+ ===============================================================================
+ |                 License - Public Domain (www.unlicense.org)                 |
+ ===============================================================================
+ *
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
@@ -15,7 +15,23 @@
  |                               Version History                               |
  ===============================================================================
  *
- - v0.3 (Current)
+ - v0.4 (Current)
+     - 'SPLU_MAP()' is now available in header-file mode and parenthesizes its
+       arguments.
+     - Added 'splu_mapf()', 'splu_mapd()', 'splu_lerpf()', 'splu_clampf()',
+       'splu_mapf_n()' and 'splu_rampf()'.
+     - Added an asynchronous logger, compiled in with 'SPLU_LOG':
+       'splu_log_init()', 'splu_log()', 'splu_log_flush()' and
+       'splu_log_shutdown()'. 'splu_die()' flushes it before exiting.
+     - Added 'splu_time_ns()' and 'splu_rdtsc()' timers and the 'SPLU_PROF_*()'
+       profiling macros writing Chrome trace files.
+     - Added a fixed-size object pool with per-thread caches and statistics,
+       compiled in with 'SPLU_POOL': 'splu_pool_create()',
+       'splu_pool_destroy()', 'splu_pool_alloc()', 'splu_pool_release()',
+       'splu_pool_release_all()' and 'splu_pool_get_stats()'.
+     - Added 'splu_file_open()', 'splu_file_open_fd()' and 'splu_file_close()'
+       to map or read whole files, compiled in with 'SPLU_FILE'.
+ - v0.3
      - Removed 'SPLU_HEXCOLOR(hex)' and 'SPLU_HEXCOLORA(hex)' macros from the
        previous version into a separate header file.
      - Added 'SPLU_MAP()' macro.
@@ -48,6 +64,28 @@
 #define SPLU_DEF /* You may want `static` or `static inline` here */
 #endif
 
+/* = SPLU_LOG = */
+/* Define 'SPLU_LOG' in every file, the one with 'SPLU_IMPL' included, to
+ * compile in the logger. It needs a POSIX system and threads (link with
+ * '-pthread') and, with a strict '-std=c99', '_POSIX_C_SOURCE' defined to
+ * 200809L. */
+
+/* = SPLU_POOL = */
+/* Same as the logger for the object pool, with 'SPLU_POOL'. */
+
+/* = SPLU_FILE = */
+/* Same as the logger for the file functions, with 'SPLU_FILE', minus the
+ * threads. Files of at least 'SPLU_FILE_MAP_MIN' bytes are mapped, smaller
+ * ones are read. */
+#ifndef SPLU_FILE_MAP_MIN
+#define SPLU_FILE_MAP_MIN (64 * 1024)
+#endif
+
+/* = SPLU_PROF = */
+/* Define 'SPLU_PROF' in every file, the one with 'SPLU_IMPL' included, to
+ * compile in the 'SPLU_PROF_*()' macros. Otherwise they expand to nothing.
+ * Profiling needs GCC or Clang. */
+
 /*
  ===============================================================================
  |                              HEADER-FILE MODE                               |
@@ -62,6 +100,193 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ ===============================================================================
+ |                                   Macros                                    |
+ ===============================================================================
+ */
+
+/* Get the `p`% value between [`p_min`, `p_max`] and use it to get the
+ * percentaged value between `a` and `b`.
+ *
+ * Arguments are evaluated more than once; see 'splu_mapf()' and 'splu_mapd()'
+ * for typed versions which don't. */
+#define SPLU_MAP(p, p_min, p_max, a, b) \
+	((a) + ((b) - (a)) * (((p) - (p_min)) / ((p_max) - (p_min))))
+
+/*
+ * = PROFILING =
+ *
+ * 'SPLU_PROF_ZONE(name)' times the rest of the enclosing block as `name`, and
+ * 'SPLU_PROF_FUNC()' the rest of the function. 'SPLU_PROF_BEGIN(name)' and
+ * 'SPLU_PROF_END(name)' time spans not matching a block. `name` must be a
+ * string literal or outlive the profile.
+ *
+ * Each thread appends its timings to its own buffer, with 'splu_rdtsc()' and
+ * no lock. 'SPLU_PROF_DUMP(path)' writes them all as a Chrome trace JSON file,
+ * viewable in chrome://tracing or Perfetto, and returns 0 or -1 on failure.
+ * 'SPLU_PROF_CLEAR()' discards them. No thread may be profiling while either
+ * of the two runs.
+ */
+#ifdef SPLU_PROF
+#define SPLU__PROF_CAT2(a, b) a##b
+#define SPLU__PROF_CAT(a, b)  SPLU__PROF_CAT2(a, b)
+#define SPLU_PROF_ZONE(name)                                                  \
+	splu_prof_zone SPLU__PROF_CAT(splu__prof_zone_, __LINE__)             \
+		__attribute__((cleanup(splu__prof_zone_end))) = { (name),     \
+		                                                  splu_rdtsc() }
+#define SPLU_PROF_FUNC()      SPLU_PROF_ZONE(__func__)
+#define SPLU_PROF_BEGIN(name) splu__prof_record((name), 'B', splu_rdtsc(), 0)
+#define SPLU_PROF_END(name)   splu__prof_record((name), 'E', splu_rdtsc(), 0)
+#define SPLU_PROF_DUMP(path)  splu_prof_dump(path)
+#define SPLU_PROF_CLEAR()     splu_prof_clear()
+#else
+#define SPLU_PROF_ZONE(name)  ((void)0)
+#define SPLU_PROF_FUNC()      ((void)0)
+#define SPLU_PROF_BEGIN(name) ((void)0)
+#define SPLU_PROF_END(name)   ((void)0)
+#define SPLU_PROF_DUMP(path)  (0)
+#define SPLU_PROF_CLEAR()     ((void)0)
+#endif
+
+/*
+ ===============================================================================
+ |                              Inline Functions                               |
+ ===============================================================================
+ */
+
+/* Defined here rather than in the implementation so that every file including
+ * this header can have them inlined. */
+
+/* 'SPLU_MAP()' for floats. */
+static inline float
+splu_mapf(float p, float p_min, float p_max, float a, float b)
+{
+	return a + (b - a) * ((p - p_min) / (p_max - p_min));
+}
+
+/* 'SPLU_MAP()' for doubles. */
+static inline double
+splu_mapd(double p, double p_min, double p_max, double a, double b)
+{
+	return a + (b - a) * ((p - p_min) / (p_max - p_min));
+}
+
+/* Returns the value `t` of the way from `a` to `b`, `t` being in [0, 1]. */
+static inline float
+splu_lerpf(float a, float b, float t)
+{
+	return a + (b - a) * t;
+}
+
+/* Returns `v` clamped to [`lo`, `hi`]. */
+static inline float
+splu_clampf(float v, float lo, float hi)
+{
+	return v < lo ? lo : v > hi ? hi : v;
+}
+
+/* Returns a monotonic time in nanoseconds, only meaningful as a difference.
+ *
+ * Without 'CLOCK_MONOTONIC' (e.g. a strict '-std=c99' without
+ * '_POSIX_C_SOURCE'), falls back to the processor time of 'clock()'. */
+static inline uint64_t
+splu_time_ns(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	return (uint64_t)clock() * (1000000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+/* Returns the CPU time-stamp counter (the virtual counter on AArch64): the
+ * cheapest timer there is, ticking at a fixed but unknown rate. Falls back to
+ * 'splu_time_ns()' elsewhere. */
+static inline uint64_t
+splu_rdtsc(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	uint32_t lo, hi;
+
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return (uint64_t)hi << 32 | lo;
+#elif defined(__GNUC__) && defined(__aarch64__)
+	uint64_t v;
+
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+	return v;
+#else
+	return splu_time_ns();
+#endif
+}
+
+/*
+ ===============================================================================
+ |                                    Data                                     |
+ ===============================================================================
+ */
+
+/* = PROFILING = */
+
+#ifdef SPLU_PROF
+/* A 'SPLU_PROF_ZONE()' in progress */
+typedef struct {
+	const char *name;
+	uint64_t    start;
+} splu_prof_zone;
+#endif
+
+/* = LOGGING = */
+
+#ifdef SPLU_LOG
+typedef enum {
+	SPLU_LOG_DEBUG,
+	SPLU_LOG_INFO,
+	SPLU_LOG_WARN,
+	SPLU_LOG_ERROR,
+} splu_log_level;
+#endif
+
+/* = OBJECT POOL = */
+
+#ifdef SPLU_POOL
+typedef struct splu_pool splu_pool;
+
+typedef struct {
+	size_t   live;           /* Objects allocated and not released */
+	size_t   peak;           /* See 'splu_pool_get_stats()' */
+	uint64_t allocs;         /* Allocations in total */
+	double   allocs_per_sec; /* Since the previous call */
+	size_t   bytes;          /* Memory taken from 'malloc()' */
+} splu_pool_stats;
+#endif
+
+/* = FILES = */
+
+#ifdef SPLU_FILE
+typedef enum {
+	SPLU_FILE_SEQUENTIAL = 1 << 0, /* Read ahead aggressively */
+	SPLU_FILE_RANDOM     = 1 << 1, /* Do not read ahead */
+	SPLU_FILE_WILLNEED   = 1 << 2, /* Start reading the whole file now */
+	SPLU_FILE_HUGEPAGES  = 1 << 3, /* Back with huge pages if possible */
+	SPLU_FILE_WRITABLE   = 1 << 4, /* Allow editing 'data' in place */
+} splu_file_flags;
+
+/* The contents of a file. spl_str.h takes lengths as 'int', so files of more
+ * than 'INT_MAX' bytes have to be passed to it in pieces. */
+typedef struct {
+	char  *data;    /* Always followed by a '\0' */
+	size_t len;
+	size_t map_len; /* Private; 0 when read into memory */
+} splu_file;
+#endif
 
 /*
  ===============================================================================
@@ -77,30 +302,183 @@
  *
  * If a semicolon `:` is present at the end of the string, perror() is also
  * called appending the error.
+ *
+ * The logger, if running, is flushed first.
  */
 SPLU_DEF void
 splu_die(const char *fmt, ...);
 
-#endif /* SPLU_H */
+/*
+ * 'splu_mapf()' for the `n` values of `src`, writing into `dst` which may be
+ * the same array.
+ *
+ * The division is done once for the whole array and the loop is simple enough
+ * for compilers to vectorize.
+ */
+SPLU_DEF void
+splu_mapf_n(float *dst, const float *src, size_t n, float p_min, float p_max,
+            float a, float b);
+
+/* Fills `dst` with `n` evenly spaced values from `a` to `b`, both included. */
+SPLU_DEF void
+splu_rampf(float *dst, size_t n, float a, float b);
 
 /*
- ===============================================================================
- |                             IMPLEMENTATION MODE                             |
- ===============================================================================
+ * = LOGGING =
+ *
+ * Logging only copies the format string pointer and the arguments into a ring
+ * buffer owned by the calling thread, without any lock or system call. A
+ * background thread formats the messages and writes them in large batches.
+ *
+ * As formatting is deferred, `fmt` must stay valid while the logger runs (a
+ * string literal), while '%s' arguments are copied right away. Messages keep
+ * their order within a thread but not across threads. When a thread logs
+ * faster than the messages get written, its ring fills up and further messages
+ * are dropped and counted rather than blocking the thread.
  */
+#ifdef SPLU_LOG
 
-#ifdef SPLU_IMPL
+/* Starts the logger writing messages of `level` and above to the file
+ * descriptor `fd`, each thread getting a ring of `ring_size` bytes (0 for 64
+ * KiB). Returns 0 on success or -1 if already running or on failure. */
+SPLU_DEF int
+splu_log_init(int fd, splu_log_level level, size_t ring_size);
+
+/* Logs a printf-style message, prefixed with the time and `level` and followed
+ * by a newline. Does nothing if the logger is not running. */
+SPLU_DEF void
+splu_log(splu_log_level level, const char *fmt, ...);
+
+/* Waits until every message logged before the call is written. */
+SPLU_DEF void
+splu_log_flush(void);
+
+/* Writes the pending messages and stops the logger. No thread may log while
+ * this runs. */
+SPLU_DEF void
+splu_log_shutdown(void);
+
+#endif /* SPLU_LOG */
+
+/*
+ * = OBJECT POOL =
+ *
+ * Hands out objects of a single size carved from large chunks, much faster
+ * than 'malloc()' and without its per-object overhead. Released objects go on
+ * a free list of the releasing thread, which only returns them to the pool,
+ * under a lock, a batch at a time: most allocations and releases take no lock.
+ * Objects may be released by another thread than the one which allocated
+ * them.
+ */
+#ifdef SPLU_POOL
+
+/* Returns a pool of objects of `obj_size` bytes, aligned as 'malloc()' would
+ * for that size, or NULL on allocation failure. If `with_stats` is non-zero,
+ * allocations and releases are counted for 'splu_pool_get_stats()'. */
+SPLU_DEF splu_pool *
+splu_pool_create(size_t obj_size, int with_stats);
+
+/* Frees `pool` along with all of its objects. No thread may use it anymore. */
+SPLU_DEF void
+splu_pool_destroy(splu_pool *pool);
+
+/* Returns an uninitialized object from `pool`, or NULL on allocation
+ * failure. */
+SPLU_DEF void *
+splu_pool_alloc(splu_pool *pool);
+
+/* Gives `obj`, allocated from `pool`, back to it. */
+SPLU_DEF void
+splu_pool_release(splu_pool *pool, void *obj);
+
+/* Releases every object of `pool` at once, giving its memory back to
+ * 'malloc()'. No other thread may use the pool meanwhile. */
+SPLU_DEF void
+splu_pool_release_all(splu_pool *pool);
+
+/* Fills `stats` for `pool`. Without `with_stats` at creation, only 'bytes' is
+ * set. 'peak' counts the objects held in the per-thread free lists too, so it
+ * may exceed the true peak by a couple of batches per thread. */
+SPLU_DEF void
+splu_pool_get_stats(splu_pool *pool, splu_pool_stats *stats);
+
+#endif /* SPLU_POOL */
+
+/*
+ * = FILES =
+ *
+ * Large regular files are mapped read-only, so their pages come straight from
+ * the page cache without being copied. Small files and pipes are read into an
+ * allocated buffer instead, in as few 'read()' calls as possible. Either way
+ * the contents are followed by a '\0'.
+ *
+ * The 'splu_file_flags' hints apply to mapped files, passed to
+ * 'posix_madvise()'. 'SPLU_FILE_HUGEPAGES' asks Linux for transparent huge
+ * pages, which only the file systems supporting them (like tmpfs) honor.
+ * 'SPLU_FILE_WRITABLE' maps the pages copy-on-write: editing them costs a
+ * copy of each touched page but never changes the file.
+ */
+#ifdef SPLU_FILE
+
+/* Opens the file at `path` into `file` with the 'splu_file_flags' `flags`.
+ * Returns 0 on success or -1 with 'errno' set on failure. */
+SPLU_DEF int
+splu_file_open(splu_file *file, const char *path, int flags);
+
+/* Same as 'splu_file_open()' for the open file descriptor `fd`, read from its
+ * current offset if it is not mapped. `fd` is left open. */
+SPLU_DEF int
+splu_file_open_fd(splu_file *file, int fd, int flags);
+
+/* Unmaps or frees the contents of `file`. */
+SPLU_DEF void
+splu_file_close(splu_file *file);
+
+#endif /* SPLU_FILE */
+
+/* = PROFILING = */
+#ifdef SPLU_PROF
+
+/* See 'SPLU_PROF_DUMP()'. */
+SPLU_DEF int
+splu_prof_dump(const char *path);
+
+/* See 'SPLU_PROF_CLEAR()'. */
+SPLU_DEF void
+splu_prof_clear(void);
+
+/* Used by the macros: records a Chrome trace event of phase `ph`. */
+SPLU_DEF void
+splu__prof_record(const char *name, char ph, uint64_t ts, uint64_t dur);
+
+/* Used by the macros: records the end of `zone`. */
+SPLU_DEF void
+splu__prof_zone_end(splu_prof_zone *zone);
+
+#endif /* SPLU_PROF */
+
+#endif /* SPLU_H */
 
 /*
  ===============================================================================
- |                                   Macros                                    |
+ |                             IMPLEMENTATION MODE                             |
  ===============================================================================
  */
 
-/* Get the `p`% value between [`p_min`, `p_max`] and use it to get the
- * percentaged value between `a` and `b`. */
-#define SPLU_MAP(p, p_min, p_max, a, b) \
-	a + (b - a) * ((p - p_min) / (p_max - p_min))
+#ifdef SPLU_IMPL
+
+#if defined(SPLU_LOG) || defined(SPLU_POOL)
+#include <stddef.h>
+#include <pthread.h>
+#endif
+#if defined(SPLU_LOG) || defined(SPLU_FILE)
+#include <unistd.h>
+#endif
+#ifdef SPLU_FILE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /*
  ===============================================================================
@@ -113,6 +491,12 @@ splu_die(const char *fmt, ...)
 {
 	va_list ap;
 
+#ifdef SPLU_LOG
+	int err = errno;
+	splu_log_flush();
+	errno = err;
+#endif
+
 	va_start(ap, fmt);
 	vfprintf(stderr, fmt, ap);
 	va_end(ap);
@@ -130,6 +514,1449 @@ splu_die(const char *fmt, ...)
 	exit(EXIT_FAILURE);
 }
 
+SPLU_DEF void
+splu_mapf_n(float *dst, const float *src, size_t n, float p_min, float p_max,
+            float a, float b)
+{
+	float scale = (b - a) / (p_max - p_min);
+
+	for (size_t i = 0; i < n; i++)
+		dst[i] = a + (src[i] - p_min) * scale;
+}
+
+SPLU_DEF void
+splu_rampf(float *dst, size_t n, float a, float b)
+{
+	float step;
+
+	if (n == 0)
+		return;
+	if (n == 1) {
+		dst[0] = a;
+		return;
+	}
+
+	step = (b - a) / (float)(n - 1);
+	for (size_t i = 0; i < n - 1; i++)
+		dst[i] = a + step * (float)i;
+	dst[n - 1] = b;
+}
+
+/* = LOGGING = */
+
+#ifdef SPLU_LOG
+
+#define SPLU__LOG_ALIGN(n) (((n) + 7) & ~(size_t)7)
+#define SPLU__LOG_HDR      SPLU__LOG_ALIGN(sizeof(splu__log_rec))
+#define SPLU__LOG_PAD      0xffffffffu /* Level of the filler before a wrap */
+#define SPLU__LOG_OUT_SIZE 65536
+
+/* Header of a message in a ring, followed by its captured arguments, each in
+ * an 8 byte aligned slot */
+typedef struct {
+	uint32_t        size; /* Of the whole record, a multiple of 8 */
+	uint32_t        level;
+	struct timespec ts;
+	const char     *fmt;
+} splu__log_rec;
+
+/* Single-producer single-consumer ring of a thread. Positions only grow and
+ * are masked with `cap - 1`. */
+typedef struct splu__log_ring {
+	char                  *data;
+	size_t                 cap;
+	uint64_t               dropped;
+	int                    dead; /* Its thread exited */
+	struct splu__log_ring *next;
+	char                   pad0[64];
+	uint64_t               head; /* Written by the logging thread */
+	char                   pad1[64];
+	uint64_t               tail; /* Written by the writer thread */
+} splu__log_ring;
+
+/* A parsed conversion specification */
+typedef struct {
+	const char *flags;
+	int         flags_len;
+	int         width, prec; /* -1 when absent */
+	int         width_star, prec_star;
+	int         left; /* A negative '*' width was given */
+	const char *len;
+	int         len_len;
+	char        conv;
+	int         kind;
+} splu__log_spec;
+
+/* How an argument is captured */
+enum {
+	SPLU__ARG_NONE, /* '%%' or an unknown conversion */
+	SPLU__ARG_INT,
+	SPLU__ARG_LL,
+	SPLU__ARG_ULL,
+	SPLU__ARG_DBL,
+	SPLU__ARG_LDBL,
+	SPLU__ARG_PTR,
+	SPLU__ARG_STR,
+	SPLU__ARG_SKIP, /* '%n', '%lc' and '%ls': consumed but not printed */
+};
+
+static const char *splu__log_names[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+static int             splu__log_running;
+static int             splu__log_fd;
+static int             splu__log_level;
+static size_t          splu__log_ring_size;
+static unsigned        splu__log_gen;
+static pthread_t       splu__log_thread;
+static pthread_key_t   splu__log_key;
+static pthread_mutex_t splu__log_lock = PTHREAD_MUTEX_INITIALIZER;
+static splu__log_ring *splu__log_rings; /* Protected by 'splu__log_lock' */
+static uint64_t        splu__log_flush_req;
+static uint64_t        splu__log_flush_done;
+
+/* Only touched by the writer thread */
+static char   splu__log_out[SPLU__LOG_OUT_SIZE];
+static size_t splu__log_out_len;
+static time_t splu__log_sec = -1;
+static char   splu__log_stamp[32];
+
+/* Parses the conversion specification following a '%' at `p`. Returns the
+ * character after it, or the terminating null byte. */
+static const char *
+splu__log_parse(const char *p, splu__log_spec *spec)
+{
+	spec->flags = p;
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	spec->flags_len  = p - spec->flags;
+	spec->width      = -1;
+	spec->prec       = -1;
+	spec->width_star = 0;
+	spec->prec_star  = 0;
+	spec->left       = 0;
+
+	if (*p == '*') {
+		spec->width_star = 1;
+		p++;
+	} else if (*p >= '0' && *p <= '9') {
+		for (spec->width = 0; *p >= '0' && *p <= '9'; p++)
+			spec->width = spec->width * 10 + (*p - '0');
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->prec_star = 1;
+			p++;
+		} else {
+			for (spec->prec = 0; *p >= '0' && *p <= '9'; p++)
+				spec->prec = spec->prec * 10 + (*p - '0');
+		}
+	}
+
+	spec->len = p;
+	while (*p && strchr("hlLqjzt", *p))
+		p++;
+	spec->len_len = p - spec->len;
+	spec->conv    = *p;
+
+	switch (*p) {
+	case 'd':
+	case 'i':
+		spec->kind = SPLU__ARG_LL;
+		break;
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		spec->kind = SPLU__ARG_ULL;
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		spec->kind = spec->len_len && spec->len[0] == 'L' ?
+		                     SPLU__ARG_LDBL :
+		                     SPLU__ARG_DBL;
+		break;
+	case 'c':
+		spec->kind = spec->len_len ? SPLU__ARG_SKIP : SPLU__ARG_INT;
+		break;
+	case 's':
+		spec->kind = spec->len_len ? SPLU__ARG_SKIP : SPLU__ARG_STR;
+		break;
+	case 'p':
+		spec->kind = SPLU__ARG_PTR;
+		break;
+	case 'n':
+		spec->kind = SPLU__ARG_SKIP;
+		break;
+	default:
+		spec->kind = SPLU__ARG_NONE;
+		return *p ? p + 1 : p;
+	}
+	return p + 1;
+}
+
+/* Reads a signed integer argument of the length modifier of `spec`. */
+static long long
+splu__log_arg_ll(const splu__log_spec *spec, va_list *ap)
+{
+	const char *l = spec->len;
+
+	switch (spec->len_len ? l[0] : 0) {
+	case 'h':
+		if (spec->len_len == 2)
+			return (signed char)va_arg(*ap, int);
+		return (short)va_arg(*ap, int);
+	case 'l':
+		if (spec->len_len == 2)
+			return va_arg(*ap, long long);
+		return va_arg(*ap, long);
+	case 'q':
+		return va_arg(*ap, long long);
+	case 'j':
+		return va_arg(*ap, intmax_t);
+	case 'z':
+	case 't':
+		return va_arg(*ap, ptrdiff_t);
+	default:
+		return va_arg(*ap, int);
+	}
+}
+
+/* Reads an unsigned integer argument of the length modifier of `spec`. */
+static unsigned long long
+splu__log_arg_ull(const splu__log_spec *spec, va_list *ap)
+{
+	const char *l = spec->len;
+
+	switch (spec->len_len ? l[0] : 0) {
+	case 'h':
+		if (spec->len_len == 2)
+			return (unsigned char)va_arg(*ap, unsigned);
+		return (unsigned short)va_arg(*ap, unsigned);
+	case 'l':
+		if (spec->len_len == 2)
+			return va_arg(*ap, unsigned long long);
+		return va_arg(*ap, unsigned long);
+	case 'q':
+		return va_arg(*ap, unsigned long long);
+	case 'j':
+		return va_arg(*ap, uintmax_t);
+	case 'z':
+		return va_arg(*ap, size_t);
+	case 't':
+		return (size_t)va_arg(*ap, ptrdiff_t);
+	default:
+		return va_arg(*ap, unsigned);
+	}
+}
+
+/* Captures the arguments of `fmt` into `dst`, or only measures them if `dst`
+ * is NULL. Returns the number of bytes taken. */
+static size_t
+splu__log_capture(char *dst, const char *fmt, va_list *ap)
+{
+	splu__log_spec spec;
+	size_t         n = 0;
+	const char    *s;
+	size_t         s_len;
+	long long      ll;
+
+	for (const char *p = fmt; *p;) {
+		if (*p++ != '%')
+			continue;
+		p = splu__log_parse(p, &spec);
+		if (spec.width_star) {
+			ll = va_arg(*ap, int);
+			if (dst)
+				memcpy(dst + n, &ll, sizeof(ll));
+			n += 8;
+		}
+		if (spec.prec_star) {
+			ll = va_arg(*ap, int);
+			if (dst)
+				memcpy(dst + n, &ll, sizeof(ll));
+			n += 8;
+			spec.prec = (int)ll;
+		}
+
+		switch (spec.kind) {
+		case SPLU__ARG_NONE:
+			if (spec.conv != '%')
+				return n;
+			break;
+		case SPLU__ARG_INT:
+		case SPLU__ARG_LL:
+			ll = spec.kind == SPLU__ARG_INT ?
+			             va_arg(*ap, int) :
+			             splu__log_arg_ll(&spec, ap);
+			if (dst)
+				memcpy(dst + n, &ll, sizeof(ll));
+			n += 8;
+			break;
+		case SPLU__ARG_ULL: {
+			unsigned long long ull = splu__log_arg_ull(&spec, ap);
+			if (dst)
+				memcpy(dst + n, &ull, sizeof(ull));
+			n += 8;
+			break;
+		}
+		case SPLU__ARG_DBL: {
+			double d = va_arg(*ap, double);
+			if (dst)
+				memcpy(dst + n, &d, sizeof(d));
+			n += 8;
+			break;
+		}
+		case SPLU__ARG_LDBL: {
+			long double ld = va_arg(*ap, long double);
+			if (dst)
+				memcpy(dst + n, &ld, sizeof(ld));
+			n += SPLU__LOG_ALIGN(sizeof(ld));
+			break;
+		}
+		case SPLU__ARG_PTR: {
+			void *ptr = va_arg(*ap, void *);
+			if (dst)
+				memcpy(dst + n, &ptr, sizeof(ptr));
+			n += 8;
+			break;
+		}
+		case SPLU__ARG_STR:
+			/* The length, then the bytes and a null byte. A
+			 * precision bounds a string which may not be
+			 * terminated. */
+			s = va_arg(*ap, const char *);
+			if (!s)
+				s = "(null)";
+			s_len = 0;
+			if (spec.prec < 0)
+				s_len = strlen(s);
+			else
+				while (s_len < (size_t)spec.prec && s[s_len])
+					s_len++;
+			if (dst) {
+				memcpy(dst + n, &s_len, sizeof(s_len));
+				memcpy(dst + n + 8, s, s_len);
+				dst[n + 8 + s_len] = '\0';
+			}
+			n += 8 + SPLU__LOG_ALIGN(s_len + 1);
+			break;
+		case SPLU__ARG_SKIP:
+			if (spec.conv == 'c')
+				(void)va_arg(*ap, int);
+			else
+				(void)va_arg(*ap, void *);
+			break;
+		}
+	}
+	return n;
+}
+
+/* Writes out the formatted messages. */
+static void
+splu__log_out_flush(void)
+{
+	size_t  off = 0;
+	ssize_t w;
+
+	while (off < splu__log_out_len) {
+		w = write(splu__log_fd, splu__log_out + off,
+		          splu__log_out_len - off);
+		if (w < 0 && errno == EINTR)
+			continue;
+		if (w <= 0)
+			break; /* Nowhere to report it; the batch is lost */
+		off += w;
+	}
+	splu__log_out_len = 0;
+}
+
+/* Appends `len` bytes of `s` to the output, flushing it when full. */
+static void
+splu__log_out_put(const char *s, size_t len)
+{
+	size_t room;
+
+	while (len) {
+		if (splu__log_out_len == SPLU__LOG_OUT_SIZE)
+			splu__log_out_flush();
+		room = SPLU__LOG_OUT_SIZE - splu__log_out_len;
+		if (room > len)
+			room = len;
+		memcpy(splu__log_out + splu__log_out_len, s, room);
+		splu__log_out_len += room;
+		s += room;
+		len -= room;
+	}
+}
+
+/* Appends the time and level prefix of a message. */
+static void
+splu__log_out_prefix(const struct timespec *ts, unsigned level)
+{
+	char      buf[64];
+	struct tm tm;
+	int       len;
+
+	/* 'localtime_r()' is slow enough to be worth caching per second */
+	if (ts->tv_sec != splu__log_sec) {
+		localtime_r(&ts->tv_sec, &tm);
+		strftime(splu__log_stamp, sizeof(splu__log_stamp),
+		         "%Y-%m-%d %H:%M:%S", &tm);
+		splu__log_sec = ts->tv_sec;
+	}
+	len = snprintf(buf, sizeof(buf), "%s.%03ld %s ", splu__log_stamp,
+	               (long)(ts->tv_nsec / 1000000), splu__log_names[level]);
+	splu__log_out_put(buf, len);
+}
+
+/* Formats the value at `arg` with the conversion `spec`, whose '*' fields are
+ * filled in, and appends it to the output. */
+static void
+splu__log_out_spec(const splu__log_spec *spec, const char *arg)
+{
+	char   f[64];
+	size_t f_len = 0;
+	char  *out;
+	size_t room;
+	int    len = 0;
+
+	f[f_len++] = '%';
+	memcpy(f + f_len, spec->flags, spec->flags_len);
+	f_len += spec->flags_len;
+	if (spec->left)
+		f[f_len++] = '-';
+	if (spec->width >= 0)
+		f_len += sprintf(f + f_len, "%d", spec->width);
+	if (spec->prec >= 0)
+		f_len += sprintf(f + f_len, ".%d", spec->prec);
+	if (spec->kind == SPLU__ARG_LL || spec->kind == SPLU__ARG_ULL) {
+		f[f_len++] = 'l';
+		f[f_len++] = 'l';
+	} else if (spec->kind == SPLU__ARG_LDBL) {
+		f[f_len++] = 'L';
+	}
+	f[f_len++] = spec->conv;
+	f[f_len]   = '\0';
+
+#define SPLU__LOG_FMT(stored, type)                      \
+	do {                                             \
+		stored v;                                \
+		memcpy(&v, arg, sizeof(v));              \
+		len = snprintf(out, room, f, (type)v);   \
+	} while (0)
+
+	/* Formatted right into the output, flushing it once if short */
+	for (int tries = 0; tries < 2; tries++) {
+		out  = splu__log_out + splu__log_out_len;
+		room = SPLU__LOG_OUT_SIZE - splu__log_out_len;
+		switch (spec->kind) {
+		case SPLU__ARG_INT:
+			SPLU__LOG_FMT(long long, int);
+			break;
+		case SPLU__ARG_LL:
+			SPLU__LOG_FMT(long long, long long);
+			break;
+		case SPLU__ARG_ULL:
+			SPLU__LOG_FMT(unsigned long long, unsigned long long);
+			break;
+		case SPLU__ARG_DBL:
+			SPLU__LOG_FMT(double, double);
+			break;
+		case SPLU__ARG_LDBL:
+			SPLU__LOG_FMT(long double, long double);
+			break;
+		case SPLU__ARG_PTR:
+			SPLU__LOG_FMT(void *, void *);
+			break;
+		}
+		if (len < 0)
+			return;
+		if ((size_t)len < room)
+			break;
+		splu__log_out_flush();
+	}
+#undef SPLU__LOG_FMT
+
+	/* Longer than the whole output buffer; truncated */
+	if ((size_t)len >= room)
+		len = room - 1;
+	splu__log_out_len += len;
+}
+
+/* Appends a captured string, padded to the width of `spec`. */
+static void
+splu__log_out_str(const splu__log_spec *spec, const char *s, size_t len)
+{
+	static const char spaces[] = "                ";
+	size_t            pad      = 0;
+	int               left;
+
+	left = spec->left || memchr(spec->flags, '-', spec->flags_len);
+	if (spec->width >= 0 && (size_t)spec->width > len)
+		pad = spec->width - len;
+
+	if (left)
+		splu__log_out_put(s, len);
+	for (; pad > sizeof(spaces) - 1; pad -= sizeof(spaces) - 1)
+		splu__log_out_put(spaces, sizeof(spaces) - 1);
+	splu__log_out_put(spaces, pad);
+	if (!left)
+		splu__log_out_put(s, len);
+}
+
+/* Formats the message of `rec` from its captured arguments and appends it to
+ * the output. */
+static void
+splu__log_out_rec(const splu__log_rec *rec)
+{
+	const char    *arg = (const char *)rec + SPLU__LOG_HDR;
+	const char    *lit;
+	splu__log_spec spec;
+	long long      ll;
+	size_t         s_len;
+
+	splu__log_out_prefix(&rec->ts, rec->level);
+
+	for (const char *p = rec->fmt; *p;) {
+		lit = p;
+		while (*p && *p != '%')
+			p++;
+		splu__log_out_put(lit, p - lit);
+		if (!*p)
+			break;
+
+		lit = p;
+		p   = splu__log_parse(p + 1, &spec);
+		if (spec.width_star) {
+			memcpy(&ll, arg, sizeof(ll));
+			arg += 8;
+			spec.left  = ll < 0;
+			spec.width = (int)(ll < 0 ? -ll : ll);
+		}
+		if (spec.prec_star) {
+			memcpy(&ll, arg, sizeof(ll));
+			arg += 8;
+			spec.prec = (int)ll;
+		}
+
+		switch (spec.kind) {
+		case SPLU__ARG_NONE:
+			if (spec.conv == '%') {
+				splu__log_out_put("%", 1);
+				break;
+			}
+			/* Not captured past an unknown conversion */
+			splu__log_out_put(lit, strlen(lit));
+			p = "";
+			break;
+		case SPLU__ARG_STR:
+			memcpy(&s_len, arg, sizeof(s_len));
+			splu__log_out_str(&spec, arg + 8, s_len);
+			arg += 8 + SPLU__LOG_ALIGN(s_len + 1);
+			break;
+		case SPLU__ARG_SKIP:
+			break;
+		case SPLU__ARG_LDBL:
+			splu__log_out_spec(&spec, arg);
+			arg += SPLU__LOG_ALIGN(sizeof(long double));
+			break;
+		default:
+			splu__log_out_spec(&spec, arg);
+			arg += 8;
+			break;
+		}
+	}
+	splu__log_out_put("\n", 1);
+}
+
+/* Formats every message published in `ring`. Returns how many there were. */
+static int
+splu__log_drain(splu__log_ring *ring)
+{
+	uint64_t             head, tail = ring->tail;
+	uint64_t             dropped;
+	size_t               pos;
+	const splu__log_rec *rec;
+	struct timespec      ts;
+	char                 buf[64];
+	int                  got = 0;
+
+	dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+	if (dropped) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		splu__log_out_prefix(&ts, SPLU_LOG_WARN);
+		splu__log_out_put(buf, sprintf(buf, "%llu messages dropped\n",
+		                               (unsigned long long)dropped));
+	}
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	while (tail != head) {
+		pos = tail & (ring->cap - 1);
+		if (ring->cap - pos < SPLU__LOG_HDR) {
+			tail += ring->cap - pos;
+			continue;
+		}
+		rec = (const splu__log_rec *)(ring->data + pos);
+		if (rec->level != SPLU__LOG_PAD) {
+			splu__log_out_rec(rec);
+			got++;
+		}
+		tail += rec->size;
+	}
+	/* Only now may the thread reuse the space */
+	__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	return got;
+}
+
+static void
+splu__log_ring_free(splu__log_ring *ring)
+{
+	free(ring->data);
+	free(ring);
+}
+
+/* Destructor of a thread's ring key: the writer frees it once drained. */
+static void
+splu__log_ring_exit(void *ring)
+{
+	__atomic_store_n(&((splu__log_ring *)ring)->dead, 1, __ATOMIC_RELEASE);
+}
+
+/* Returns the ring of the calling thread, creating it on its first message. */
+static splu__log_ring *
+splu__log_ring_get(void)
+{
+	static __thread splu__log_ring *ring;
+	static __thread unsigned        gen;
+
+	if (ring && gen == splu__log_gen)
+		return ring;
+
+	ring = (splu__log_ring *)calloc(1, sizeof(*ring));
+	if (!ring)
+		return NULL;
+	ring->cap  = splu__log_ring_size;
+	ring->data = (char *)malloc(ring->cap);
+	if (!ring->data) {
+		free(ring);
+		return ring = NULL;
+	}
+	gen = splu__log_gen;
+	pthread_setspecific(splu__log_key, ring);
+
+	pthread_mutex_lock(&splu__log_lock);
+	ring->next      = splu__log_rings;
+	splu__log_rings = ring;
+	pthread_mutex_unlock(&splu__log_lock);
+	return ring;
+}
+
+/* The writer thread. Polls the rings, sleeping while they are all empty. */
+static void *
+splu__log_writer(void *arg)
+{
+	struct timespec  nap = { 0, 1000000 };
+	splu__log_ring **link, *ring;
+	uint64_t         flush_req;
+	int              stop, got;
+
+	(void)arg;
+	for (;;) {
+		stop = !__atomic_load_n(&splu__log_running, __ATOMIC_ACQUIRE);
+		flush_req =
+			__atomic_load_n(&splu__log_flush_req, __ATOMIC_ACQUIRE);
+		got = 0;
+
+		pthread_mutex_lock(&splu__log_lock);
+		for (link = &splu__log_rings; (ring = *link);) {
+			/* Checked before draining so nothing is left behind */
+			int dead = __atomic_load_n(&ring->dead,
+			                           __ATOMIC_ACQUIRE);
+			got += splu__log_drain(ring);
+			if (dead) {
+				*link = ring->next;
+				splu__log_ring_free(ring);
+			} else {
+				link = &ring->next;
+			}
+		}
+		pthread_mutex_unlock(&splu__log_lock);
+
+		splu__log_out_flush();
+		__atomic_store_n(&splu__log_flush_done, flush_req,
+		                 __ATOMIC_RELEASE);
+
+		if (stop && !got)
+			return NULL;
+		if (!got && flush_req == __atomic_load_n(&splu__log_flush_req,
+		                                         __ATOMIC_ACQUIRE))
+			nanosleep(&nap, NULL);
+	}
+}
+
+SPLU_DEF int
+splu_log_init(int fd, splu_log_level level, size_t ring_size)
+{
+	if (splu__log_running)
+		return -1;
+
+	if (ring_size == 0)
+		ring_size = 65536;
+	for (splu__log_ring_size = 4096; splu__log_ring_size < ring_size;)
+		splu__log_ring_size <<= 1;
+	splu__log_fd    = fd;
+	splu__log_level = level;
+	splu__log_gen++;
+
+	if (pthread_key_create(&splu__log_key, splu__log_ring_exit) != 0)
+		return -1;
+	__atomic_store_n(&splu__log_running, 1, __ATOMIC_RELEASE);
+	if (pthread_create(&splu__log_thread, NULL, splu__log_writer, NULL) !=
+	    0) {
+		splu__log_running = 0;
+		pthread_key_delete(splu__log_key);
+		return -1;
+	}
+	return 0;
+}
+
+SPLU_DEF void
+splu_log(splu_log_level level, const char *fmt, ...)
+{
+	splu__log_ring *ring;
+	splu__log_rec  *rec;
+	va_list         ap, ap2;
+	uint64_t        head, tail;
+	size_t          pos, skip, need;
+
+	if (!__atomic_load_n(&splu__log_running, __ATOMIC_ACQUIRE) ||
+	    (int)level < splu__log_level)
+		return;
+	if (!(ring = splu__log_ring_get()))
+		return;
+
+	va_start(ap, fmt);
+	va_copy(ap2, ap);
+	need = SPLU__LOG_HDR + splu__log_capture(NULL, fmt, &ap2);
+	va_end(ap2);
+
+	/* Contiguous space is needed, skipping the end of the ring if short */
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	pos  = head & (ring->cap - 1);
+	skip = ring->cap - pos < need ? ring->cap - pos : 0;
+	if (need > ring->cap / 2 || head + skip + need - tail > ring->cap) {
+		__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+		va_end(ap);
+		return;
+	}
+	if (skip >= SPLU__LOG_HDR) {
+		rec        = (splu__log_rec *)(ring->data + pos);
+		rec->size  = skip;
+		rec->level = SPLU__LOG_PAD;
+	}
+
+	rec = (splu__log_rec *)(ring->data + ((head + skip) & (ring->cap - 1)));
+	rec->size  = need;
+	rec->level = level;
+	rec->fmt   = fmt;
+	clock_gettime(CLOCK_REALTIME, &rec->ts);
+	splu__log_capture((char *)rec + SPLU__LOG_HDR, fmt, &ap);
+	va_end(ap);
+
+	__atomic_store_n(&ring->head, head + skip + need, __ATOMIC_RELEASE);
+}
+
+SPLU_DEF void
+splu_log_flush(void)
+{
+	struct timespec nap = { 0, 100000 };
+	uint64_t        req;
+
+	if (!__atomic_load_n(&splu__log_running, __ATOMIC_ACQUIRE))
+		return;
+	req = __atomic_add_fetch(&splu__log_flush_req, 1, __ATOMIC_ACQ_REL);
+	while (__atomic_load_n(&splu__log_flush_done, __ATOMIC_ACQUIRE) < req)
+		nanosleep(&nap, NULL);
+}
+
+SPLU_DEF void
+splu_log_shutdown(void)
+{
+	splu__log_ring *ring;
+
+	if (!splu__log_running)
+		return;
+	__atomic_store_n(&splu__log_running, 0, __ATOMIC_RELEASE);
+	pthread_join(splu__log_thread, NULL);
+	pthread_key_delete(splu__log_key);
+
+	while ((ring = splu__log_rings)) {
+		splu__log_rings = ring->next;
+		splu__log_ring_free(ring);
+	}
+}
+
+#endif /* SPLU_LOG */
+
+/* = OBJECT POOL = */
+
+#ifdef SPLU_POOL
+
+#define SPLU__POOL_BATCH 32 /* Objects moved between a thread and the pool */
+
+/* Free list of a thread. Its counters are only written by the thread. */
+typedef struct splu__pool_cache {
+	void                    *free;
+	size_t                   count;
+	uint64_t                 allocs, releases;
+	struct splu_pool        *pool;
+	struct splu__pool_cache *next;
+} splu__pool_cache;
+
+struct splu_pool {
+	size_t            obj_size;
+	size_t            chunk_size; /* Bytes, header included */
+	int               with_stats;
+	pthread_key_t     key;        /* To the free list of a thread */
+	pthread_mutex_t   lock;       /* Protects everything below */
+	void             *free;       /* Objects returned by threads */
+	void             *chunks;     /* Each starts with the next one */
+	size_t            chunks_c;
+	char             *bump, *bump_end; /* Not yet handed out of a chunk */
+	splu__pool_cache *caches;
+	size_t            out;        /* Objects handed to threads */
+	size_t            peak;
+	uint64_t          allocs, releases; /* Of exited threads */
+	uint64_t          last_allocs, last_ns;
+};
+
+/* Chunks start with the pointer to the next one, padded to keep objects
+ * aligned */
+#define SPLU__POOL_CHUNK_HDR 16
+
+/* Moves up to a batch of objects from `pool` to `c`. Returns the number
+ * moved, 0 on allocation failure. */
+static size_t
+splu__pool_refill(splu_pool *pool, splu__pool_cache *c)
+{
+	size_t n = 0;
+	void  *obj;
+
+	pthread_mutex_lock(&pool->lock);
+	for (; n < SPLU__POOL_BATCH && pool->free; n++) {
+		obj        = pool->free;
+		pool->free = *(void **)obj;
+		*(void **)obj = c->free;
+		c->free       = obj;
+	}
+	for (; n < SPLU__POOL_BATCH; n++) {
+		if (pool->bump == pool->bump_end) {
+			char *chunk = (char *)malloc(pool->chunk_size);
+			if (!chunk)
+				break;
+			*(void **)chunk = pool->chunks;
+			pool->chunks    = chunk;
+			pool->chunks_c++;
+			pool->bump     = chunk + SPLU__POOL_CHUNK_HDR;
+			pool->bump_end = chunk + pool->chunk_size;
+		}
+		obj = pool->bump;
+		pool->bump += pool->obj_size;
+		*(void **)obj = c->free;
+		c->free       = obj;
+	}
+	c->count += n;
+	pool->out += n;
+	if (pool->out > pool->peak)
+		pool->peak = pool->out;
+	pthread_mutex_unlock(&pool->lock);
+	return n;
+}
+
+/* Moves `n` objects from `c` back to `pool`. */
+static void
+splu__pool_flush(splu_pool *pool, splu__pool_cache *c, size_t n)
+{
+	void *first = c->free, *last = c->free;
+
+	if (!n)
+		return;
+	for (size_t i = 1; i < n; i++)
+		last = *(void **)last;
+	c->free = *(void **)last;
+	c->count -= n;
+
+	pthread_mutex_lock(&pool->lock);
+	*(void **)last = pool->free;
+	pool->free     = first;
+	pool->out -= n;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/* Key destructor: returns the free list of an exiting thread to its pool. */
+static void
+splu__pool_cache_exit(void *arg)
+{
+	splu__pool_cache  *c = (splu__pool_cache *)arg;
+	splu__pool_cache **link;
+	splu_pool         *pool;
+
+	pool = c->pool;
+	splu__pool_flush(pool, c, c->count);
+
+	pthread_mutex_lock(&pool->lock);
+	for (link = &pool->caches; *link != c; link = &(*link)->next)
+		;
+	*link = c->next;
+	pool->allocs += c->allocs;
+	pool->releases += c->releases;
+	pthread_mutex_unlock(&pool->lock);
+	free(c);
+}
+
+/* Returns the free list of the calling thread, creating it on first use. */
+static splu__pool_cache *
+splu__pool_cache_get(splu_pool *pool)
+{
+	splu__pool_cache *c;
+
+	c = (splu__pool_cache *)pthread_getspecific(pool->key);
+	if (c)
+		return c;
+
+	c = (splu__pool_cache *)calloc(1, sizeof(*c));
+	if (!c)
+		return NULL;
+	c->pool = pool;
+	pthread_setspecific(pool->key, c);
+
+	pthread_mutex_lock(&pool->lock);
+	c->next      = pool->caches;
+	pool->caches = c;
+	pthread_mutex_unlock(&pool->lock);
+	return c;
+}
+
+SPLU_DEF splu_pool *
+splu_pool_create(size_t obj_size, int with_stats)
+{
+	splu_pool *pool = (splu_pool *)calloc(1, sizeof(*pool));
+	size_t     align;
+
+	if (!pool)
+		return NULL;
+
+	/* Slots are at least a pointer large to hold the free list link, and
+	 * sizes are rounded up to a multiple of 16 from 16 bytes on, of 8 from
+	 * 8 bytes on, and of the pointer size below, so that objects packed
+	 * after the chunk header keep that alignment */
+	if (obj_size < sizeof(void *))
+		obj_size = sizeof(void *);
+	align = obj_size >= 16 ? 16 : obj_size >= 8 ? 8 : sizeof(void *);
+	pool->obj_size = (obj_size + align - 1) & ~(align - 1);
+
+	/* Chunks of 64 KiB, or of 64 objects when these are large */
+	pool->chunk_size = pool->obj_size < 1024 ? 65536 : pool->obj_size * 64;
+	pool->chunk_size -= (pool->chunk_size - SPLU__POOL_CHUNK_HDR) %
+	                    pool->obj_size;
+	pool->with_stats = with_stats;
+	pool->last_ns    = splu_time_ns();
+
+	if (pthread_key_create(&pool->key, splu__pool_cache_exit) != 0) {
+		free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	return pool;
+}
+
+/* Frees the chunks of `pool` and empties every free list. */
+static void
+splu__pool_drop(splu_pool *pool)
+{
+	void *chunk;
+
+	while ((chunk = pool->chunks)) {
+		pool->chunks = *(void **)chunk;
+		free(chunk);
+	}
+	pool->chunks_c = 0;
+	pool->free     = NULL;
+	pool->bump     = NULL;
+	pool->bump_end = NULL;
+	pool->out      = 0;
+}
+
+SPLU_DEF void
+splu_pool_destroy(splu_pool *pool)
+{
+	splu__pool_cache *c;
+
+	if (!pool)
+		return;
+	pthread_key_delete(pool->key);
+	while ((c = pool->caches)) {
+		pool->caches = c->next;
+		free(c);
+	}
+	splu__pool_drop(pool);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
+SPLU_DEF void *
+splu_pool_alloc(splu_pool *pool)
+{
+	splu__pool_cache *c = splu__pool_cache_get(pool);
+	void             *obj;
+
+	if (!c || (!c->free && !splu__pool_refill(pool, c)))
+		return NULL;
+
+	obj     = c->free;
+	c->free = *(void **)obj;
+	c->count--;
+	if (pool->with_stats)
+		__atomic_store_n(&c->allocs, c->allocs + 1, __ATOMIC_RELAXED);
+	return obj;
+}
+
+SPLU_DEF void
+splu_pool_release(splu_pool *pool, void *obj)
+{
+	splu__pool_cache *c = splu__pool_cache_get(pool);
+
+	if (!c)
+		return; /* The object is lost until 'splu_pool_release_all()' */
+
+	*(void **)obj = c->free;
+	c->free       = obj;
+	c->count++;
+	if (pool->with_stats)
+		__atomic_store_n(&c->releases, c->releases + 1,
+		                 __ATOMIC_RELAXED);
+
+	/* Keeps a batch for the next allocations */
+	if (c->count >= 2 * SPLU__POOL_BATCH)
+		splu__pool_flush(pool, c, SPLU__POOL_BATCH);
+}
+
+SPLU_DEF void
+splu_pool_release_all(splu_pool *pool)
+{
+	splu__pool_cache *c;
+	uint64_t          live;
+
+	pthread_mutex_lock(&pool->lock);
+	live = pool->allocs - pool->releases;
+	for (c = pool->caches; c; c = c->next) {
+		c->free  = NULL;
+		c->count = 0;
+		live += c->allocs - c->releases;
+	}
+	pool->releases += live;
+	splu__pool_drop(pool);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+SPLU_DEF void
+splu_pool_get_stats(splu_pool *pool, splu_pool_stats *stats)
+{
+	splu__pool_cache *c;
+	uint64_t          allocs, releases, now;
+
+	memset(stats, 0, sizeof(*stats));
+
+	pthread_mutex_lock(&pool->lock);
+	stats->bytes = pool->chunks_c * pool->chunk_size;
+	if (!pool->with_stats) {
+		pthread_mutex_unlock(&pool->lock);
+		return;
+	}
+
+	/* Releases are read first so that 'live' can't go negative */
+	releases = pool->releases;
+	allocs   = pool->allocs;
+	for (c = pool->caches; c; c = c->next)
+		releases += __atomic_load_n(&c->releases, __ATOMIC_RELAXED);
+	for (c = pool->caches; c; c = c->next)
+		allocs += __atomic_load_n(&c->allocs, __ATOMIC_RELAXED);
+
+	now                   = splu_time_ns();
+	stats->live           = allocs - releases;
+	stats->peak           = pool->peak;
+	stats->allocs         = allocs;
+	stats->allocs_per_sec = now > pool->last_ns ?
+	                                (allocs - pool->last_allocs) * 1e9 /
+	                                        (now - pool->last_ns) :
+	                                0;
+	pool->last_allocs     = allocs;
+	pool->last_ns         = now;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+#endif /* SPLU_POOL */
+
+/* = FILES = */
+
+#ifdef SPLU_FILE
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Reads `fd` until EOF into `file`, expecting `size` bytes. */
+static int
+splu__file_read(splu_file *file, int fd, size_t size)
+{
+	size_t  cap = size ? size + 1 : 4096, len = 0;
+	char   *buf = (char *)malloc(cap), *grown, c;
+	ssize_t n;
+
+	if (!buf)
+		return -1;
+	for (;;) {
+		/* Once full, a byte is read aside to see if there is more, as
+		 * from a pipe or a file which grew, before growing */
+		if (len + 1 == cap)
+			n = read(fd, &c, 1);
+		else
+			n = read(fd, buf + len, cap - 1 - len);
+		if (n == 0)
+			break;
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			free(buf);
+			return -1;
+		}
+		if (len + 1 == cap) {
+			if (!(grown = (char *)realloc(buf, cap * 2))) {
+				free(buf);
+				return -1;
+			}
+			buf      = grown;
+			cap     *= 2;
+			buf[len] = c;
+			n        = 1;
+		}
+		len += n;
+	}
+
+	buf[len]      = '\0';
+	file->data    = buf;
+	file->len     = len;
+	file->map_len = 0;
+	return 0;
+}
+
+/* Maps the `size` bytes of `fd` into `file`, followed by a zeroed page so the
+ * contents end with a '\0' even when filling their last page. */
+static int
+splu__file_map(splu_file *file, int fd, size_t size, int flags)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t map  = (size + page - 1) / page * page;
+	int    prot = PROT_READ | (flags & SPLU_FILE_WRITABLE ? PROT_WRITE : 0);
+	char  *p;
+
+	/* Reserve the range with anonymous pages, then map the file over */
+	map += page;
+#ifdef MAP_ANONYMOUS
+	p = (char *)mmap(NULL, map, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#else
+	int zero = open("/dev/zero", O_RDONLY);
+	p = (char *)mmap(NULL, map, prot, MAP_PRIVATE, zero, 0);
+	if (zero >= 0)
+		close(zero);
+#endif
+	if (p == MAP_FAILED)
+		return -1;
+	if (mmap(p, size, prot, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		int err = errno;
+		munmap(p, map);
+		errno = err;
+		return -1;
+	}
+
+	/* Hints are best effort; failures are not errors */
+	if (flags & SPLU_FILE_SEQUENTIAL)
+		posix_madvise(p, size, POSIX_MADV_SEQUENTIAL);
+	if (flags & SPLU_FILE_RANDOM)
+		posix_madvise(p, size, POSIX_MADV_RANDOM);
+	if (flags & SPLU_FILE_WILLNEED)
+		posix_madvise(p, size, POSIX_MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+	if (flags & SPLU_FILE_HUGEPAGES)
+		madvise(p, size, MADV_HUGEPAGE);
+#endif
+
+	file->data    = p;
+	file->len     = size;
+	file->map_len = map;
+	return 0;
+}
+
+SPLU_DEF int
+splu_file_open(splu_file *file, const char *path, int flags)
+{
+	int fd = open(path, O_RDONLY), ret, err;
+
+	if (fd < 0)
+		return -1;
+	ret = splu_file_open_fd(file, fd, flags);
+	err = errno;
+	close(fd);
+	errno = err;
+	return ret;
+}
+
+SPLU_DEF int
+splu_file_open_fd(splu_file *file, int fd, int flags)
+{
+	struct stat st;
+
+	if (fstat(fd, &st) < 0)
+		return -1;
+	if (!S_ISREG(st.st_mode))
+		return splu__file_read(file, fd, 0);
+	if (st.st_size < SPLU_FILE_MAP_MIN)
+		return splu__file_read(file, fd, (size_t)st.st_size);
+	return splu__file_map(file, fd, (size_t)st.st_size, flags);
+}
+
+SPLU_DEF void
+splu_file_close(splu_file *file)
+{
+	if (file->map_len)
+		munmap(file->data, file->map_len);
+	else
+		free(file->data);
+	file->data    = NULL;
+	file->len     = 0;
+	file->map_len = 0;
+}
+
+#endif /* SPLU_FILE */
+
+/* = PROFILING = */
+
+#ifdef SPLU_PROF
+
+#define SPLU__PROF_CHUNK 4096 /* Events */
+
+typedef struct {
+	const char *name;
+	uint64_t    ts, dur; /* In 'splu_rdtsc()' ticks */
+	char        ph;
+} splu__prof_event;
+
+typedef struct splu__prof_chunk {
+	struct splu__prof_chunk *next;
+	size_t                   count;
+	splu__prof_event         events[SPLU__PROF_CHUNK];
+} splu__prof_chunk;
+
+/* Events of a thread, appended only by it */
+typedef struct splu__prof_thread {
+	struct splu__prof_thread *next;
+	int                       tid;
+	splu__prof_chunk         *first, *last;
+} splu__prof_thread;
+
+static splu__prof_thread *splu__prof_threads;
+static int                splu__prof_tids;
+static unsigned           splu__prof_gen;
+static uint64_t           splu__prof_tsc0, splu__prof_ns0;
+
+/* Returns the events of the calling thread, creating them on its first one. */
+static splu__prof_thread *
+splu__prof_thread_get(void)
+{
+	static __thread splu__prof_thread *t;
+	static __thread unsigned           gen;
+
+	if (t && gen == __atomic_load_n(&splu__prof_gen, __ATOMIC_ACQUIRE))
+		return t;
+
+	t = (splu__prof_thread *)calloc(1, sizeof(*t));
+	if (!t)
+		return NULL;
+	t->first = t->last = (splu__prof_chunk *)calloc(1, sizeof(*t->last));
+	if (!t->first) {
+		free(t);
+		return t = NULL;
+	}
+	t->tid = __atomic_add_fetch(&splu__prof_tids, 1, __ATOMIC_RELAXED);
+	gen    = __atomic_load_n(&splu__prof_gen, __ATOMIC_ACQUIRE);
+
+	/* The first thread sets the base the ticks get converted from */
+	if (!__atomic_load_n(&splu__prof_threads, __ATOMIC_ACQUIRE)) {
+		uint64_t zero = 0;
+		if (__atomic_compare_exchange_n(&splu__prof_ns0, &zero,
+		                                splu_time_ns(), 0,
+		                                __ATOMIC_ACQ_REL,
+		                                __ATOMIC_RELAXED))
+			splu__prof_tsc0 = splu_rdtsc();
+	}
+
+	t->next = __atomic_load_n(&splu__prof_threads, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&splu__prof_threads, &t->next, t,
+	                                    1, __ATOMIC_RELEASE,
+	                                    __ATOMIC_RELAXED))
+		;
+	return t;
+}
+
+SPLU_DEF void
+splu__prof_record(const char *name, char ph, uint64_t ts, uint64_t dur)
+{
+	splu__prof_thread *t = splu__prof_thread_get();
+	splu__prof_chunk  *c;
+	splu__prof_event  *e;
+
+	if (!t)
+		return;
+	c = t->last;
+	if (c->count == SPLU__PROF_CHUNK) {
+		c = (splu__prof_chunk *)calloc(1, sizeof(*c));
+		if (!c)
+			return;
+		__atomic_store_n(&t->last->next, c, __ATOMIC_RELEASE);
+		t->last = c;
+	}
+
+	e       = &c->events[c->count];
+	e->name = name;
+	e->ts   = ts;
+	e->dur  = dur;
+	e->ph   = ph;
+	__atomic_store_n(&c->count, c->count + 1, __ATOMIC_RELEASE);
+}
+
+SPLU_DEF void
+splu__prof_zone_end(splu_prof_zone *zone)
+{
+	splu__prof_record(zone->name, 'X', zone->start,
+	                  splu_rdtsc() - zone->start);
+}
+
+/* Returns the ticks of the earliest event, as zones may have started before
+ * the base was taken. */
+static uint64_t
+splu__prof_ts0(void)
+{
+	const splu__prof_thread *t;
+	const splu__prof_chunk  *c;
+	size_t                   count;
+	uint64_t                 ts0 = splu__prof_tsc0;
+
+	for (t = __atomic_load_n(&splu__prof_threads, __ATOMIC_ACQUIRE); t;
+	     t = t->next) {
+		for (c = t->first; c;
+		     c = __atomic_load_n(&c->next, __ATOMIC_ACQUIRE)) {
+			count = __atomic_load_n(&c->count, __ATOMIC_ACQUIRE);
+			for (size_t i = 0; i < count; i++)
+				if (c->events[i].ts < ts0)
+					ts0 = c->events[i].ts;
+		}
+	}
+	return ts0;
+}
+
+/* Writes the event `e` of the thread `tid` as JSON. */
+static void
+splu__prof_write(FILE *f, const splu__prof_event *e, int tid, uint64_t ts0,
+                 double us_per_tick)
+{
+	fputs("{\"name\":\"", f);
+	/* Only quotes and backslashes are expected */
+	for (const char *s = e->name; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', f);
+		fputc(*s, f);
+	}
+	fprintf(f, "\",\"ph\":\"%c\",\"ts\":%.3f", e->ph,
+	        (e->ts - ts0) * us_per_tick);
+	if (e->ph == 'X')
+		fprintf(f, ",\"dur\":%.3f", e->dur * us_per_tick);
+	fprintf(f, ",\"pid\":1,\"tid\":%d}", tid);
+}
+
+SPLU_DEF int
+splu_prof_dump(const char *path)
+{
+	const splu__prof_thread *t;
+	const splu__prof_chunk  *c;
+	uint64_t                 tsc1, ns1, ts0;
+	double                   us_per_tick = 0;
+	size_t                   count;
+	const char              *sep = "\n";
+	FILE                    *f;
+
+	if (!(f = fopen(path, "w")))
+		return -1;
+
+	/* Rate of the ticks over the whole profile, measured over at least a
+	 * millisecond */
+	do {
+		tsc1 = splu_rdtsc();
+		ns1  = splu_time_ns();
+	} while (ns1 - splu__prof_ns0 < 1000000);
+	if (tsc1 != splu__prof_tsc0)
+		us_per_tick = (ns1 - splu__prof_ns0) / 1000.0 /
+		              (double)(tsc1 - splu__prof_tsc0);
+	ts0 = splu__prof_ts0();
+
+	fputs("{\"traceEvents\":[", f);
+	for (t = __atomic_load_n(&splu__prof_threads, __ATOMIC_ACQUIRE); t;
+	     t = t->next) {
+		for (c = t->first; c;
+		     c = __atomic_load_n(&c->next, __ATOMIC_ACQUIRE)) {
+			count = __atomic_load_n(&c->count, __ATOMIC_ACQUIRE);
+			for (size_t i = 0; i < count; i++) {
+				fputs(sep, f);
+				splu__prof_write(f, &c->events[i], t->tid, ts0,
+				                 us_per_tick);
+				sep = ",\n";
+			}
+		}
+	}
+	fputs("\n]}\n", f);
+
+	return fclose(f) == 0 ? 0 : -1;
+}
+
+SPLU_DEF void
+splu_prof_clear(void)
+{
+	splu__prof_thread *t;
+	splu__prof_chunk  *c;
+
+	t = __atomic_exchange_n(&splu__prof_threads, NULL, __ATOMIC_ACQ_REL);
+	while (t) {
+		splu__prof_thread *next = t->next;
+		while ((c = t->first)) {
+			t->first = c->next;
+			free(c);
+		}
+		free(t);
+		t = next;
+	}
+	splu__prof_ns0 = 0;
+	__atomic_add_fetch(&splu__prof_gen, 1, __ATOMIC_RELEASE);
+}
+
+#endif /* SPLU_PROF */
+
 #endif /* SPLU_IMPL */
 
 /*